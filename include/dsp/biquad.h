@@ -0,0 +1,432 @@
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Biquads and one-poles: filter sections designed in Hz for the actual rate
+//
+// The coefficient designs take the sample rate and a frequency in Hz, so a
+// filter keeps its corner wherever the host runs (and at the oversampled
+// rates). Biquads follow the RBJ Audio EQ Cookbook, bilinear with the corner
+// prewarped; the one-poles are the same lowpass/highpass lerps the stages
+// used to write inline, with their pole placed exactly for the rate.
+//
+// Sections run in transposed direct form II, two state values per biquad and
+// one per one-pole. BiquadLanes and OnePoleLanes run NumLanes independent
+// sections side by side, each with its own coefficients: the channels of a
+// stereo pair, or the parallel lines of a reverb. Every step of the
+// recursion is then one operation across the lanes, which the compiler
+// turns into one SIMD instruction: a stereo pair of doubles or four floats
+// per SSE register, eight floats with AVX. FilterCascade puts sections in
+// series.
+//-----------------------------------------------------------------------------
+namespace FilterDetail {
+
+// Corner in radians per sample. Corners at or past Nyquist have no bilinear
+// image, so they are held just below it
+inline double cornerOmega(double sampleRate, double frequency)
+{
+    const double nyquist = 0.5 * sampleRate;
+    return 2.0 * 3.14159265358979323846 * std::max(1e-3, std::min(frequency, 0.98 * nyquist)) / sampleRate;
+}
+
+} // namespace FilterDetail
+
+//-----------------------------------------------------------------------------
+// Biquad coefficients, normalised so the leading denominator term is 1
+//-----------------------------------------------------------------------------
+struct BiquadCoefficients
+{
+    double b0, b1, b2;
+    double a1, a2;
+
+    // Passes the signal unchanged
+    static BiquadCoefficients identity()
+    {
+        return {1.0, 0.0, 0.0, 0.0, 0.0};
+    }
+
+    // Second order lowpass and highpass; q = 0.7071 is Butterworth
+    static BiquadCoefficients lowpass(double sampleRate, double frequency, double q)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double cosw = std::cos(w);
+        const double alpha = std::sin(w) / (2.0 * q);
+        return normalise((1.0 - cosw) * 0.5, 1.0 - cosw, (1.0 - cosw) * 0.5,
+                         1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+    }
+
+    static BiquadCoefficients highpass(double sampleRate, double frequency, double q)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double cosw = std::cos(w);
+        const double alpha = std::sin(w) / (2.0 * q);
+        return normalise((1.0 + cosw) * 0.5, -(1.0 + cosw), (1.0 + cosw) * 0.5,
+                         1.0 + alpha, -2.0 * cosw, 1.0 - alpha);
+    }
+
+    // Constant skirt gain bandpass, 0 dB at the centre
+    static BiquadCoefficients bandpass(double sampleRate, double frequency, double q)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double alpha = std::sin(w) / (2.0 * q);
+        return normalise(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * std::cos(w), 1.0 - alpha);
+    }
+
+    // Bell boosting or cutting gainDb around the centre
+    static BiquadCoefficients peak(double sampleRate, double frequency, double q, double gainDb)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double cosw = std::cos(w);
+        const double alpha = std::sin(w) / (2.0 * q);
+        const double a = std::pow(10.0, gainDb / 40.0);
+        return normalise(1.0 + alpha * a, -2.0 * cosw, 1.0 - alpha * a,
+                         1.0 + alpha / a, -2.0 * cosw, 1.0 - alpha / a);
+    }
+
+    // Shelves boosting or cutting gainDb below or above the corner; q = 0.7071
+    // is the steepest slope without overshoot
+    static BiquadCoefficients lowShelf(double sampleRate, double frequency, double q, double gainDb)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double cosw = std::cos(w);
+        const double a = std::pow(10.0, gainDb / 40.0);
+        const double beta = 2.0 * std::sqrt(a) * std::sin(w) / (2.0 * q);
+        return normalise(a * ((a + 1.0) - (a - 1.0) * cosw + beta),
+                         2.0 * a * ((a - 1.0) - (a + 1.0) * cosw),
+                         a * ((a + 1.0) - (a - 1.0) * cosw - beta),
+                         (a + 1.0) + (a - 1.0) * cosw + beta,
+                         -2.0 * ((a - 1.0) + (a + 1.0) * cosw),
+                         (a + 1.0) + (a - 1.0) * cosw - beta);
+    }
+
+    static BiquadCoefficients highShelf(double sampleRate, double frequency, double q, double gainDb)
+    {
+        const double w = FilterDetail::cornerOmega(sampleRate, frequency);
+        const double cosw = std::cos(w);
+        const double a = std::pow(10.0, gainDb / 40.0);
+        const double beta = 2.0 * std::sqrt(a) * std::sin(w) / (2.0 * q);
+        return normalise(a * ((a + 1.0) + (a - 1.0) * cosw + beta),
+                         -2.0 * a * ((a - 1.0) + (a + 1.0) * cosw),
+                         a * ((a + 1.0) + (a - 1.0) * cosw - beta),
+                         (a + 1.0) - (a - 1.0) * cosw + beta,
+                         2.0 * ((a - 1.0) - (a + 1.0) * cosw),
+                         (a + 1.0) - (a - 1.0) * cosw - beta);
+    }
+
+private:
+    static BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+    }
+};
+
+//-----------------------------------------------------------------------------
+// One-pole coefficients: y = b0 x + s, s' = b1 x - a1 y
+//-----------------------------------------------------------------------------
+struct OnePoleCoefficients
+{
+    double b0, b1;
+    double a1;
+
+    static OnePoleCoefficients identity()
+    {
+        return {1.0, 0.0, 0.0};
+    }
+
+    // y += (x - y) (1 - p), with the pole p = e^(-2 pi f / fs) matching the
+    // analog corner; unity at DC
+    static OnePoleCoefficients lowpass(double sampleRate, double frequency)
+    {
+        const double pole = std::exp(-2.0 * 3.14159265358979323846 * std::max(0.0, frequency) / sampleRate);
+        return {1.0 - pole, 0.0, -pole};
+    }
+
+    // The DC blocker y = g (x - x[n-1]) + p y[n-1], with the same pole and
+    // g = (1 + p) / 2 for unity at Nyquist
+    static OnePoleCoefficients highpass(double sampleRate, double frequency)
+    {
+        const double pole = std::exp(-2.0 * 3.14159265358979323846 * std::max(0.0, frequency) / sampleRate);
+        const double gain = (1.0 + pole) * 0.5;
+        return {gain, -gain, -pole};
+    }
+
+    // First order shelf: unity at DC and gainDb at Nyquist, with the pole at
+    // the corner (bilinear, prewarped)
+    static OnePoleCoefficients highShelf(double sampleRate, double frequency, double gainDb)
+    {
+        const double k = std::tan(0.5 * FilterDetail::cornerOmega(sampleRate, frequency));
+        const double g = std::pow(10.0, gainDb / 20.0);
+        return {(g + k) / (1.0 + k), (k - g) / (1.0 + k), (k - 1.0) / (1.0 + k)};
+    }
+};
+
+//-----------------------------------------------------------------------------
+// NumLanes independent biquads, lane by lane in structure-of-arrays layout
+//-----------------------------------------------------------------------------
+template <typename T, int NumLanes>
+class BiquadLanes
+{
+public:
+    static constexpr int kNumLanes = NumLanes;
+
+    BiquadLanes()
+    {
+        setCoefficients(BiquadCoefficients::identity());
+        reset();
+    }
+
+    void setCoefficients(int lane, const BiquadCoefficients& c)
+    {
+        mB0[lane] = (T)c.b0;
+        mB1[lane] = (T)c.b1;
+        mB2[lane] = (T)c.b2;
+        mA1[lane] = (T)c.a1;
+        mA2[lane] = (T)c.a2;
+    }
+
+    // The same response on every lane, as for a stereo pair
+    void setCoefficients(const BiquadCoefficients& c)
+    {
+        for (int lane = 0; lane < NumLanes; lane++)
+            setCoefficients(lane, c);
+    }
+
+    void reset()
+    {
+        for (int lane = 0; lane < NumLanes; lane++) {
+            mS1[lane] = 0;
+            mS2[lane] = 0;
+        }
+    }
+
+    // One sample through the first Used lanes (every lane by default), in
+    // place: x[lane] in, y[lane] out
+    template <int Used = NumLanes>
+    void tick(T* x)
+    {
+        static_assert(Used >= 1 && Used <= NumLanes, "one lane per input");
+        for (int lane = 0; lane < Used; lane++) {
+            const T in = x[lane];
+            const T y = mB0[lane] * in + mS1[lane];
+            mS1[lane] = mB1[lane] * in - mA1[lane] * y + mS2[lane];
+            mS2[lane] = mB2[lane] * in - mA2[lane] * y;
+            x[lane] = y;
+        }
+    }
+
+    // One sample through a single lane
+    T processSample(T x, int lane = 0)
+    {
+        const T y = mB0[lane] * x + mS1[lane];
+        mS1[lane] = mB1[lane] * x - mA1[lane] * y + mS2[lane];
+        mS2[lane] = mB2[lane] * x - mA2[lane] * y;
+        return y;
+    }
+
+    // Filter a block in place, buffers[lane] on each of the first Used lanes.
+    // The state stays in locals across the block, so the lane loops compile
+    // to register operations
+    template <int Used, typename SampleType>
+    void process(SampleType* const* buffers, Steinberg::int32 numSamples)
+    {
+        static_assert(Used >= 1 && Used <= NumLanes, "one lane per buffer");
+
+        T b0[Used], b1[Used], b2[Used], a1[Used], a2[Used], s1[Used], s2[Used];
+        for (int lane = 0; lane < Used; lane++) {
+            b0[lane] = mB0[lane];
+            b1[lane] = mB1[lane];
+            b2[lane] = mB2[lane];
+            a1[lane] = mA1[lane];
+            a2[lane] = mA2[lane];
+            s1[lane] = mS1[lane];
+            s2[lane] = mS2[lane];
+        }
+
+        for (Steinberg::int32 n = 0; n < numSamples; n++) {
+            T x[Used], y[Used];
+            for (int lane = 0; lane < Used; lane++)
+                x[lane] = (T)buffers[lane][n];
+
+            for (int lane = 0; lane < Used; lane++) {
+                y[lane] = b0[lane] * x[lane] + s1[lane];
+                s1[lane] = b1[lane] * x[lane] - a1[lane] * y[lane] + s2[lane];
+                s2[lane] = b2[lane] * x[lane] - a2[lane] * y[lane];
+            }
+
+            for (int lane = 0; lane < Used; lane++)
+                buffers[lane][n] = (SampleType)y[lane];
+        }
+
+        for (int lane = 0; lane < Used; lane++) {
+            mS1[lane] = s1[lane];
+            mS2[lane] = s2[lane];
+        }
+    }
+
+private:
+    alignas(32) T mB0[NumLanes];
+    alignas(32) T mB1[NumLanes];
+    alignas(32) T mB2[NumLanes];
+    alignas(32) T mA1[NumLanes];
+    alignas(32) T mA2[NumLanes];
+    alignas(32) T mS1[NumLanes];
+    alignas(32) T mS2[NumLanes];
+};
+
+//-----------------------------------------------------------------------------
+// NumLanes independent one-poles, laid out like BiquadLanes
+//-----------------------------------------------------------------------------
+template <typename T, int NumLanes>
+class OnePoleLanes
+{
+public:
+    static constexpr int kNumLanes = NumLanes;
+
+    OnePoleLanes()
+    {
+        setCoefficients(OnePoleCoefficients::identity());
+        reset();
+    }
+
+    void setCoefficients(int lane, const OnePoleCoefficients& c)
+    {
+        mB0[lane] = (T)c.b0;
+        mB1[lane] = (T)c.b1;
+        mA1[lane] = (T)c.a1;
+    }
+
+    void setCoefficients(const OnePoleCoefficients& c)
+    {
+        for (int lane = 0; lane < NumLanes; lane++)
+            setCoefficients(lane, c);
+    }
+
+    void reset()
+    {
+        for (int lane = 0; lane < NumLanes; lane++)
+            mS[lane] = 0;
+    }
+
+    template <int Used = NumLanes>
+    void tick(T* x)
+    {
+        static_assert(Used >= 1 && Used <= NumLanes, "one lane per input");
+        for (int lane = 0; lane < Used; lane++) {
+            const T in = x[lane];
+            const T y = mB0[lane] * in + mS[lane];
+            mS[lane] = mB1[lane] * in - mA1[lane] * y;
+            x[lane] = y;
+        }
+    }
+
+    T processSample(T x, int lane = 0)
+    {
+        const T y = mB0[lane] * x + mS[lane];
+        mS[lane] = mB1[lane] * x - mA1[lane] * y;
+        return y;
+    }
+
+    template <int Used, typename SampleType>
+    void process(SampleType* const* buffers, Steinberg::int32 numSamples)
+    {
+        static_assert(Used >= 1 && Used <= NumLanes, "one lane per buffer");
+
+        T b0[Used], b1[Used], a1[Used], s[Used];
+        for (int lane = 0; lane < Used; lane++) {
+            b0[lane] = mB0[lane];
+            b1[lane] = mB1[lane];
+            a1[lane] = mA1[lane];
+            s[lane] = mS[lane];
+        }
+
+        for (Steinberg::int32 n = 0; n < numSamples; n++) {
+            T x[Used], y[Used];
+            for (int lane = 0; lane < Used; lane++)
+                x[lane] = (T)buffers[lane][n];
+
+            for (int lane = 0; lane < Used; lane++) {
+                y[lane] = b0[lane] * x[lane] + s[lane];
+                s[lane] = b1[lane] * x[lane] - a1[lane] * y[lane];
+            }
+
+            for (int lane = 0; lane < Used; lane++)
+                buffers[lane][n] = (SampleType)y[lane];
+        }
+
+        for (int lane = 0; lane < Used; lane++)
+            mS[lane] = s[lane];
+    }
+
+    // Filter one lane's block in place, for a stage that sees one channel at a time
+    template <typename SampleType>
+    void processLane(int lane, SampleType* buffer, Steinberg::int32 numSamples)
+    {
+        const T b0 = mB0[lane], b1 = mB1[lane], a1 = mA1[lane];
+        T s = mS[lane];
+        for (Steinberg::int32 n = 0; n < numSamples; n++) {
+            const T x = (T)buffer[n];
+            const T y = b0 * x + s;
+            s = b1 * x - a1 * y;
+            buffer[n] = (SampleType)y;
+        }
+        mS[lane] = s;
+    }
+
+private:
+    alignas(32) T mB0[NumLanes];
+    alignas(32) T mB1[NumLanes];
+    alignas(32) T mA1[NumLanes];
+    alignas(32) T mS[NumLanes];
+};
+
+//-----------------------------------------------------------------------------
+// Sections in series, each a BiquadLanes or OnePoleLanes. A block runs
+// through one section at a time, so each pass is one section's lane loop
+//-----------------------------------------------------------------------------
+template <typename Section, int NumSections>
+class FilterCascade
+{
+public:
+    static constexpr int kNumSections = NumSections;
+
+    Section& operator[](int index) { return mSections[index]; }
+    const Section& operator[](int index) const { return mSections[index]; }
+
+    void reset()
+    {
+        for (int i = 0; i < NumSections; i++)
+            mSections[i].reset();
+    }
+
+    template <typename T>
+    void tick(T* x)
+    {
+        for (int i = 0; i < NumSections; i++)
+            mSections[i].tick(x);
+    }
+
+    template <typename T>
+    T processSample(T x, int lane = 0)
+    {
+        for (int i = 0; i < NumSections; i++)
+            x = mSections[i].processSample(x, lane);
+        return x;
+    }
+
+    template <int Used, typename SampleType>
+    void process(SampleType* const* buffers, Steinberg::int32 numSamples)
+    {
+        for (int i = 0; i < NumSections; i++)
+            mSections[i].template process<Used>(buffers, numSamples);
+    }
+
+private:
+    Section mSections[NumSections];
+};
+
+} // namespace MyVSTPlugin
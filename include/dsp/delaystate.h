@@ -0,0 +1,48 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include "dsp/reversedelay.h"
+#include <algorithm>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// DelayChannelState: Per-channel delay lines of the echo and reverse delay
+//
+// The modulation stage taps the same echo line for its chorus and flanger.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+struct DelayChannelState
+{
+    static constexpr double kMaxDelaySeconds = 4.0;
+
+    // ===== Echo =====
+    ArenaBuffer<SampleType> delayBuffer; // 4 seconds
+    int delayPos;
+
+    // ===== Reverse delay =====
+    ReverseDelay<SampleType> reverse;    // Segments up to the longest delay time
+
+    DelayChannelState()
+    : delayPos(0)
+    {
+    }
+
+    // Reserve or assign all buffers for the given sample rate (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate)
+    {
+        int length = std::max(2, (int)(sampleRate * kMaxDelaySeconds));
+        delayBuffer = arena.allocate<SampleType>(length);
+        reverse.layout(arena, sampleRate, kMaxDelaySeconds);
+    }
+
+    // Clear all state without touching the allocation
+    void reset()
+    {
+        delayBuffer.clear();
+        delayPos = 0;
+        reverse.reset();
+    }
+};
+
+} // namespace MyVSTPlugin
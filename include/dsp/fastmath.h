@@ -0,0 +1,152 @@
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Fast math: tanh, sin and exp for the per-sample paths
+//
+// Rational and polynomial approximations with no branches, table lookups or
+// library calls, so the block loops that call them still vectorize. Each one
+// is accurate to about float precision (maximum errors measured against libm
+// over every float in range are given with the functions); the double chain
+// gets the same accuracy, which is far below anything audible.
+//
+// Building with AMNEZIAGAZE_REFERENCE_MATH=1 routes all of them to the
+// standard library instead, for A/B comparisons against the exact functions.
+//-----------------------------------------------------------------------------
+#ifndef AMNEZIAGAZE_REFERENCE_MATH
+#define AMNEZIAGAZE_REFERENCE_MATH 0
+#endif
+
+namespace FastMathDetail {
+
+// 2^k for k within the normal range of float
+inline float powerOfTwo(float, Steinberg::int32 k)
+{
+    Steinberg::uint32 bits = (Steinberg::uint32)(k + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline double powerOfTwo(double, Steinberg::int32 k)
+{
+    Steinberg::uint64 bits = (Steinberg::uint64)(k + 1023) << 52;
+    double result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// Nearest integer, for arguments well inside the int32 range
+template <typename T>
+inline Steinberg::int32 roundToInt(T x)
+{
+    return (Steinberg::int32)(x + std::copysign((T)0.5, x));
+}
+
+} // namespace FastMathDetail
+
+//-----------------------------------------------------------------------------
+// tanh: [13/6] rational minimax fit on [-7.9, 7.9] (the one Eigen and XLA
+// use), clamped beyond, where tanh is 1 to float precision.
+// Maximum absolute error 4.2e-7 (about 7 ulp near +-1)
+//-----------------------------------------------------------------------------
+template <typename T>
+inline T fastTanh(T x)
+{
+#if AMNEZIAGAZE_REFERENCE_MATH
+    return std::tanh(x);
+#else
+    const T clamp = (T)7.90531110763549805;
+    x = std::max(-clamp, std::min(x, clamp));
+    const T x2 = x * x;
+
+    T p = (T)-2.76076847742355e-16;
+    p = p * x2 + (T)2.00018790482477e-13;
+    p = p * x2 + (T)-8.60467152213735e-11;
+    p = p * x2 + (T)5.12229709037114e-08;
+    p = p * x2 + (T)1.48572235717979e-05;
+    p = p * x2 + (T)6.37261928875436e-04;
+    p = p * x2 + (T)4.89352455891786e-03;
+
+    T q = (T)1.19825839466702e-06;
+    q = q * x2 + (T)1.18534705686654e-04;
+    q = q * x2 + (T)2.26843463243900e-03;
+    q = q * x2 + (T)4.89352518554385e-03;
+
+    return x * p / q;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// sin: reduced to [-pi, pi] by whole turns (with 2 pi split in two parts so the
+// reduction itself stays exact), folded onto [-pi/2, pi/2] and evaluated with
+// the degree 11 Taylor polynomial, whose remainder there is below 6e-8.
+// Maximum absolute error 2.3e-7 for |x| < 1000; beyond that it grows with
+// |x|, as the reduction can only be as exact as x itself
+//-----------------------------------------------------------------------------
+template <typename T>
+inline T fastSin(T x)
+{
+#if AMNEZIAGAZE_REFERENCE_MATH
+    return std::sin(x);
+#else
+    const T pi = (T)3.14159265358979323846;
+    const T halfPi = (T)1.57079632679489661923;
+    const T twoPiHigh = (T)6.28125;                        // Exact in 8 bits
+    const T twoPiLow = (T)1.93530717958647692528e-3;       // 2 pi - twoPiHigh
+
+    const T turns = (T)FastMathDetail::roundToInt(x * (T)0.15915494309189533577);
+    T r = (x - turns * twoPiHigh) - turns * twoPiLow;
+
+    // sin(r) = sin(pi - r) folds the outer quarters back in
+    const T folded = std::copysign(pi, r) - r;
+    r = std::fabs(r) > halfPi ? folded : r;
+
+    const T r2 = r * r;
+    T p = (T)-2.50521083854417187751e-8;                   // -1/11!
+    p = p * r2 + (T)2.75573192239858906526e-6;             //  1/9!
+    p = p * r2 + (T)-1.98412698412698412698e-4;            // -1/7!
+    p = p * r2 + (T)8.33333333333333333333e-3;             //  1/5!
+    p = p * r2 + (T)-1.66666666666666666667e-1;            // -1/3!
+    return r + r * r2 * p;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// exp: e^x = 2^k e^f with k the nearest integer to x / ln 2, so f stays within
+// +-ln 2 / 2 where the degree 6 Taylor polynomial is good to 1.2e-7 relative;
+// 2^k is put straight into the exponent bits. Inputs are clamped to
+// [-87, 88], the normal range of float.
+// Maximum relative error 2.6e-7
+//-----------------------------------------------------------------------------
+template <typename T>
+inline T fastExp(T x)
+{
+#if AMNEZIAGAZE_REFERENCE_MATH
+    return std::exp(x);
+#else
+    const T ln2High = (T)0.693359375;                      // Exact in 9 bits
+    const T ln2Low = (T)-2.12194440054690582e-4;           // ln 2 - ln2High
+
+    x = std::max((T)-87, std::min(x, (T)88));
+    const Steinberg::int32 k = FastMathDetail::roundToInt(x * (T)1.44269504088896340736);
+    const T f = (x - (T)k * ln2High) - (T)k * ln2Low;
+
+    T p = (T)1.38888888888888888889e-3;                    // 1/6!
+    p = p * f + (T)8.33333333333333333333e-3;              // 1/5!
+    p = p * f + (T)4.16666666666666666667e-2;              // 1/4!
+    p = p * f + (T)1.66666666666666666667e-1;              // 1/3!
+    p = p * f + (T)0.5;
+    p = p * f + (T)1;
+    p = p * f + (T)1;
+    return p * FastMathDetail::powerOfTwo(x, k);
+#endif
+}
+
+} // namespace MyVSTPlugin
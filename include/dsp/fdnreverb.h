@@ -0,0 +1,296 @@
+#pragma once
+
+#include "dsp/interpolation.h"
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// FdnReverb: Stereo feedback delay network, the core of the reverb
+//
+// The delay lines feed back into each other through an orthogonal matrix, so
+// each echo is spread over every line on the next pass and the echo density
+// grows with every pass, where parallel combs only ever repeat their own
+// echoes (the metallic ring of a comb reverb at long sizes). The matrix is a
+// Hadamard matrix, applied as a fast Walsh-Hadamard transform: log2 N
+// butterfly passes of adds and subtracts across the lines instead of N^2
+// multiply-adds. Being orthogonal it is lossless, so the decay is set by the
+// per-line gains alone, each matched to its own line's length so every line
+// falls 60 dB in the same time, and by a first order shelf per line that
+// makes the highs fall faster. The shelf is a one-pole lowpass with the
+// highs above it scaled back in, so both its corner and its depth can glide
+// with a size change; stepping the coefficients of a transposed shelf would
+// jump its state and click.
+//
+// The left channel feeds the even lines and the right the odd ones. The two
+// outputs tap every line with orthogonal sign patterns, so they come out
+// decorrelated even from a mono input.
+//
+// Every line is allocated for the largest room, and the room size only moves
+// its read tap: the taps and gains glide to a new size over a few hundred
+// milliseconds, so turning or automating Size reshapes the space with a brief
+// tape-like bend instead of a click, and never allocates. Each tap also
+// sweeps slowly by a fraction of a millisecond at its own rate, which keeps
+// the tail from settling into fixed resonances. The taps are fractional, so
+// they are read with linear interpolation.
+//
+// All lines live back to back in one arena buffer, and their heads, taps,
+// gains and sweeps sit in arrays indexed by line (structure of arrays), so
+// each per-line step of a sample is one loop across the lines and vectorizes.
+// Realtime runs eight lines, offline renders sixteen.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class FdnReverb
+{
+public:
+    static constexpr int kNumLines = 8;             // Realtime
+    static constexpr int kMaxLines = 16;            // Dense (offline)
+    static constexpr int kMaxSizeMultiplier = 4;    // Size scales the lines 1x to 4x
+    static constexpr double kGlideSeconds = 0.2;    // Time constant of a size change
+    static constexpr double kSweepSeconds = 0.00025; // Depth of the tap modulation
+
+    // Line lengths at the 44.1kHz reference rate, mutually prime and spread
+    // over 14 to 64 ms; the first eight cover the range on their own
+    static int referenceLineLength(int index)
+    {
+        static const int lengths[] = {601, 751, 929, 1151, 1409, 1723, 2099, 2551,
+                                      673, 839, 1031, 1277, 1559, 1901, 2311, 2819};
+        return lengths[index];
+    }
+
+    FdnReverb()
+    : mNumLines(kNumLines), mSnap(true), mOutputScale(0), mGlide(1), mSweepDepth(0)
+    , mLowpassStep(1), mTargetLowpassStep(1), mSampleRate(44100.0)
+    , mSizeMultiplier(1.0), mDecaySeconds(1.0), mDampedSeconds(0.5), mDampingFrequency(2000.0)
+    {
+        for (int i = 0; i < kMaxLines; i++) {
+            mOffset[i] = 0;
+            mMaxLength[i] = 0;
+            mBaseLength[i] = 1;
+            mWrite[i] = 0;
+            mTap[i] = mTargetTap[i] = 1;
+            mGain[i] = mTargetGain[i] = 0;
+            mShelf[i] = mTargetShelf[i] = 1;
+            mLowpass[i] = 0;
+            mSweepPhase[i] = mSweepIncrement[i] = 0;
+        }
+    }
+
+    // Reserve or assign the lines for the given sample rate, the extra ones
+    // of the dense variant if requested (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate, bool dense)
+    {
+        mSampleRate = sampleRate;
+        mNumLines = dense ? kMaxLines : kNumLines;
+        mOutputScale = (SampleType)(kOutputLevel / std::sqrt((double)mNumLines));
+        mGlide = (SampleType)(1.0 - std::exp(-1.0 / (kGlideSeconds * sampleRate)));
+        mSweepDepth = (SampleType)(kSweepSeconds * sampleRate);
+
+        // Room for the largest tap, its sweep and the interpolation's second sample
+        Steinberg::int32 total = 0;
+        for (int i = 0; i < kMaxLines; i++) {
+            mBaseLength[i] = std::max(1.0, std::floor(referenceLineLength(i) * sampleRate / 44100.0 + 0.5));
+            mMaxLength[i] = (i < mNumLines) ? (Steinberg::int32)(mBaseLength[i] * kMaxSizeMultiplier + mSweepDepth) + 2 : 0;
+            mOffset[i] = total;
+            total += mMaxLength[i];
+
+            // Slow sweeps, 0.25 to 1.3 Hz, each line at its own rate
+            mSweepIncrement[i] = (SampleType)(2.0 * (0.25 + 0.07 * i) / sampleRate);
+        }
+        mLines = arena.allocate<SampleType>(total);
+        updateTargets();
+    }
+
+    // Clear the lines without touching the allocation
+    void reset()
+    {
+        mLines.clear();
+        for (int i = 0; i < kMaxLines; i++) {
+            mWrite[i] = 0;
+            mLowpass[i] = 0;
+            mSweepPhase[i] = (SampleType)(2.0 * i / kMaxLines - 1.0);
+        }
+
+        // The first sample takes the room as it is set, without gliding
+        mSnap = true;
+    }
+
+    // Line length scale (1 to kMaxSizeMultiplier); the taps glide to it
+    void setSize(double sizeMultiplier)
+    {
+        mSizeMultiplier = std::max(1.0, std::min(sizeMultiplier, (double)kMaxSizeMultiplier));
+        updateTargets();
+    }
+
+    // Seconds the tail takes to fall 60 dB, overall and well above the
+    // damping corner
+    void setDecay(double decaySeconds, double dampedSeconds, double dampingFrequency)
+    {
+        mDecaySeconds = std::max(0.01, decaySeconds);
+        mDampedSeconds = std::max(0.01, std::min(dampedSeconds, mDecaySeconds));
+        mDampingFrequency = dampingFrequency;
+        updateTargets();
+    }
+
+    double getDecaySeconds() const { return mDecaySeconds; }
+
+    // Longest line, sweep included, once the taps have settled at the given
+    // length scale
+    Steinberg::int32 getLongestLine(double sizeMultiplier) const
+    {
+        const double scale = std::max(1.0, std::min(sizeMultiplier, (double)kMaxSizeMultiplier));
+        double longest = 1.0;
+        for (int i = 0; i < mNumLines; i++)
+            longest = std::max(longest, mBaseLength[i] * scale + mSweepDepth);
+        return (Steinberg::int32)std::ceil(longest);
+    }
+
+    //-------------------------------------------------------------------------
+    // One stereo frame: input[0] and input[1] in, output[0] and output[1] out.
+    // NumLines is the variant the lines were laid out for
+    template <int NumLines>
+    void process(const SampleType* input, SampleType* output)
+    {
+        static_assert(NumLines == kNumLines || NumLines == kMaxLines, "a laid out variant");
+
+        if (mSnap)
+            snapToTargets();
+
+        SampleType* lines = mLines.data;
+
+        // Glide the taps and gains to the room size, and sweep the taps with
+        // a parabolic sine, phase in [-1, 1)
+        SampleType tap[NumLines];
+        for (int i = 0; i < NumLines; i++) {
+            mTap[i] += (mTargetTap[i] - mTap[i]) * mGlide;
+            mGain[i] += (mTargetGain[i] - mGain[i]) * mGlide;
+            mShelf[i] += (mTargetShelf[i] - mShelf[i]) * mGlide;
+
+            SampleType phase = mSweepPhase[i] + mSweepIncrement[i];
+            phase = (phase >= (SampleType)1) ? phase - (SampleType)2 : phase;
+            mSweepPhase[i] = phase;
+            tap[i] = mTap[i] + mSweepDepth * (SampleType)4 * phase * ((SampleType)1 - std::fabs(phase));
+        }
+
+        // Each tap reads tap[i] samples behind the head that is written next,
+        // between the sample one older than its whole part and the next one
+        SampleType y[NumLines];
+        for (int i = 0; i < NumLines; i++) {
+            const Steinberg::int32 whole = (Steinberg::int32)tap[i];
+            Steinberg::int32 index = mWrite[i] - whole - 1;
+            index = (index < 0) ? index + mMaxLength[i] : index;
+            y[i] = readLinear(lines + mOffset[i], mMaxLength[i], index, (SampleType)1 - (tap[i] - (SampleType)whole));
+        }
+
+        // Both outputs take every line, with the signs of two rows of the
+        // Hadamard matrix
+        SampleType left = 0, right = 0;
+        for (int i = 0; i < NumLines; i++) {
+            left += y[i];
+            right += (i & 1) ? -y[i] : y[i];
+        }
+        output[0] = left * mOutputScale;
+        output[1] = right * mOutputScale;
+
+        // Damping (the highs above the lowpass scaled by the shelf), decay
+        // (with the matrix's 1/sqrt(N) folded in), then the mix
+        mLowpassStep += (mTargetLowpassStep - mLowpassStep) * mGlide;
+        for (int i = 0; i < NumLines; i++) {
+            mLowpass[i] += (y[i] - mLowpass[i]) * mLowpassStep;
+            y[i] = (mLowpass[i] + mShelf[i] * (y[i] - mLowpass[i])) * mGain[i];
+        }
+        hadamard<NumLines>(y);
+
+        for (int i = 0; i < NumLines; i++) {
+            lines[mOffset[i] + mWrite[i]] = y[i] + input[i & 1];
+            mWrite[i] = (mWrite[i] + 1 < mMaxLength[i]) ? mWrite[i] + 1 : 0;
+        }
+    }
+
+private:
+    // The outputs add up N uncorrelated lines, scaled by this over sqrt(N)
+    // so both variants come out at the same level
+    static constexpr double kOutputLevel = 0.9;
+
+    // In-place unnormalised Walsh-Hadamard transform
+    template <int N>
+    static void hadamard(SampleType* x)
+    {
+        for (int span = 1; span < N; span *= 2) {
+            for (int block = 0; block < N; block += 2 * span) {
+                for (int i = block; i < block + span; i++) {
+                    const SampleType a = x[i];
+                    const SampleType b = x[i + span];
+                    x[i] = a + b;
+                    x[i + span] = a - b;
+                }
+            }
+        }
+    }
+
+    void snapToTargets()
+    {
+        for (int i = 0; i < kMaxLines; i++) {
+            mTap[i] = mTargetTap[i];
+            mGain[i] = mTargetGain[i];
+            mShelf[i] = mTargetShelf[i];
+        }
+        mLowpassStep = mTargetLowpassStep;
+        mSnap = false;
+    }
+
+    // Per-line tap, loop gain and high shelf for the size and decay times
+    void updateTargets()
+    {
+        const double normalise = 1.0 / std::sqrt((double)mNumLines);
+        const double corner = std::min(mDampingFrequency, 0.49 * mSampleRate);
+        const double pi = 3.14159265358979323846;
+        mTargetLowpassStep = (SampleType)(1.0 - std::exp(-2.0 * pi * corner / mSampleRate));
+
+        for (int i = 0; i < mNumLines; i++) {
+            const double length = mBaseLength[i] * mSizeMultiplier;
+            const double seconds = length / mSampleRate;
+            const double gainDb = -60.0 * seconds / mDecaySeconds;
+            const double dampedDb = -60.0 * seconds / mDampedSeconds;
+            mTargetTap[i] = (SampleType)length;
+            mTargetGain[i] = (SampleType)(std::pow(10.0, gainDb / 20.0) * normalise);
+            mTargetShelf[i] = (SampleType)std::pow(10.0, (dampedDb - gainDb) / 20.0);
+        }
+    }
+
+    // Every line back to back, each mMaxLength[i] long from mOffset[i]
+    ArenaBuffer<SampleType> mLines;
+
+    // Per line
+    Steinberg::int32 mOffset[kMaxLines];
+    Steinberg::int32 mMaxLength[kMaxLines];        // Allocated for the largest room
+    Steinberg::int32 mWrite[kMaxLines];            // Write head
+    double mBaseLength[kMaxLines];                 // Length at the smallest size, in samples
+    alignas(32) SampleType mTap[kMaxLines];        // Read tap behind the write head, gliding
+    alignas(32) SampleType mTargetTap[kMaxLines];
+    alignas(32) SampleType mGain[kMaxLines];       // Loop gain over 1 pass, over sqrt(N), gliding
+    alignas(32) SampleType mTargetGain[kMaxLines];
+    alignas(32) SampleType mSweepPhase[kMaxLines];
+    alignas(32) SampleType mSweepIncrement[kMaxLines];
+    alignas(32) SampleType mShelf[kMaxLines];      // Gain above the damping corner, gliding
+    alignas(32) SampleType mTargetShelf[kMaxLines];
+    alignas(32) SampleType mLowpass[kMaxLines];    // Damping lowpass state
+
+    int mNumLines;                                 // Lines laid out: kNumLines or kMaxLines
+    bool mSnap;                                    // Take the targets without gliding
+    SampleType mOutputScale;                       // kOutputLevel over sqrt(N)
+    SampleType mGlide;                             // One-pole step towards the targets
+    SampleType mSweepDepth;                        // In samples
+    SampleType mLowpassStep;                       // Damping lowpass coefficient, gliding
+    SampleType mTargetLowpassStep;
+
+    double mSampleRate;
+    double mSizeMultiplier;
+    double mDecaySeconds;
+    double mDampedSeconds;
+    double mDampingFrequency;
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include <cmath>
+#include <utility>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Fft: In-place radix-2 complex FFT over split real and imaginary arrays
+//
+// The size is a power of two fixed in layout(), and design() fills the bit
+// reversal and twiddle tables, so a transform never allocates or calls a
+// trig function. The twiddles of each butterfly pass lie side by side in
+// their own stretch of the table, and the real and imaginary parts are
+// separate arrays (split complex), so the inner loop of every pass runs over
+// contiguous arrays with no shuffles and vectorizes across the butterflies.
+//
+// A transform of real signals packs two of them into one complex transform,
+// one as the real part and one as the imaginary part; the caller separates
+// the two spectra by their conjugate symmetry. The inverse is the forward
+// transform with the real and imaginary parts swapped, unscaled.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class Fft
+{
+public:
+    Fft() : mSize(1) {}
+
+    // Reserve or assign the tables for a transform of size points, a power
+    // of two (see ProcessArena)
+    void layout(ProcessArena& arena, Steinberg::int32 size)
+    {
+        mSize = size;
+        mBitReverse = arena.allocate<Steinberg::int32>(size);
+
+        // Pass p (butterflies half = 2^p apart) keeps its twiddles at half - 1
+        mTwiddleReal = arena.allocate<SampleType>(size);
+        mTwiddleImag = arena.allocate<SampleType>(size);
+    }
+
+    // Fill the tables once the arena has handed out the memory
+    void design()
+    {
+        if (!mBitReverse.data)
+            return;
+
+        int bits = 0;
+        while ((1 << bits) < mSize)
+            bits++;
+        for (Steinberg::int32 i = 0; i < mSize; i++) {
+            Steinberg::int32 reversed = 0;
+            for (int b = 0; b < bits; b++)
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            mBitReverse[i] = reversed;
+        }
+
+        const double pi = 3.14159265358979323846;
+        for (Steinberg::int32 half = 1; half < mSize; half *= 2) {
+            for (Steinberg::int32 k = 0; k < half; k++) {
+                mTwiddleReal[half - 1 + k] = (SampleType)std::cos(pi * k / half);
+                mTwiddleImag[half - 1 + k] = (SampleType)-std::sin(pi * k / half);
+            }
+        }
+    }
+
+    // Forward transform of size points, in place
+    void forward(SampleType* real, SampleType* imag) const
+    {
+        for (Steinberg::int32 i = 0; i < mSize; i++) {
+            const Steinberg::int32 j = mBitReverse[i];
+            if (j > i) {
+                std::swap(real[i], real[j]);
+                std::swap(imag[i], imag[j]);
+            }
+        }
+
+        for (Steinberg::int32 half = 1; half < mSize; half *= 2) {
+            const SampleType* wr = mTwiddleReal.data + half - 1;
+            const SampleType* wi = mTwiddleImag.data + half - 1;
+
+            for (Steinberg::int32 start = 0; start < mSize; start += 2 * half) {
+                SampleType* ar = real + start;
+                SampleType* ai = imag + start;
+                SampleType* br = ar + half;
+                SampleType* bi = ai + half;
+
+                for (Steinberg::int32 k = 0; k < half; k++) {
+                    const SampleType tr = br[k] * wr[k] - bi[k] * wi[k];
+                    const SampleType ti = br[k] * wi[k] + bi[k] * wr[k];
+                    br[k] = ar[k] - tr;
+                    bi[k] = ai[k] - ti;
+                    ar[k] += tr;
+                    ai[k] += ti;
+                }
+            }
+        }
+    }
+
+    // Inverse transform, in place and scaled by the size
+    void inverse(SampleType* real, SampleType* imag) const { forward(imag, real); }
+
+    Steinberg::int32 getSize() const { return mSize; }
+
+private:
+    Steinberg::int32 mSize;
+    ArenaBuffer<Steinberg::int32> mBitReverse;
+    ArenaBuffer<SampleType> mTwiddleReal;
+    ArenaBuffer<SampleType> mTwiddleImag;
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "dsp/interpolation.h"
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// GranularShifter: Two-interval granular pitch shifter for the shimmer
+//
+// Each interval is read from a short history of the input by two heads. A
+// head's delay falls steadily through a grain, so it reads ahead faster than
+// the input is written, by the pitch ratio; at the end of the grain it jumps
+// back. The jump happens where the head's Hann window is zero, and the other
+// head, half a grain apart, is then at the top of its window. Hann windows
+// half a period apart add up to exactly one, so the two heads crossfade into
+// a steady, click-free stream. The octave and the fourth run staggered by a
+// quarter grain so their jumps never line up.
+//
+// The window is a table built at compile time, like the waveshaper curves.
+// Every sample runs the same fixed work: four heads, each a table lookup and
+// one interpolated read per channel. The heads' phases, delays and gains sit
+// in per-head arrays, so the per-head arithmetic vectorizes across them.
+//-----------------------------------------------------------------------------
+namespace GranularDetail {
+
+// cos(x) for |x| <= pi from its degree 24 Taylor polynomial, good to 1e-12,
+// for building the window while the plugin compiles
+constexpr double cos(double x)
+{
+    const double x2 = x * x;
+    double sum = 1.0;
+    for (int k = 24; k >= 2; k -= 2)
+        sum = 1.0 - sum * x2 / (k * (k - 1));
+    return sum;
+}
+
+// Hann window over one grain, padded with a copy of the last point so a
+// lookup at the very end can still read index + 1
+template <int Size>
+struct alignas(64) WindowTable
+{
+    float values[Size + 2];
+};
+
+template <int Size>
+constexpr WindowTable<Size> buildWindow()
+{
+    constexpr double pi = 3.14159265358979323846;
+    WindowTable<Size> table{};
+    for (int i = 0; i <= Size; i++)
+        table.values[i] = (float)(0.5 + 0.5 * cos(2.0 * pi * ((double)i / Size - 0.5)));
+    table.values[Size + 1] = table.values[Size];
+    return table;
+}
+
+} // namespace GranularDetail
+
+template <typename SampleType>
+class GranularShifter
+{
+public:
+    static constexpr int kNumLanes = 2;             // A stereo pair
+    static constexpr int kNumIntervals = 2;         // Octave and fourth
+    static constexpr int kNumHeads = 2 * kNumIntervals;
+    static constexpr double kGrainSeconds = 0.07;
+    static constexpr int kMinDelay = 2;             // Keeps a cubic read behind the write head
+    static constexpr int kWindowSize = 512;         // Intervals
+
+    // Semitones up and level of each interval
+    static double intervalSemitones(int interval) { return interval == 0 ? 12.0 : 5.0; }
+    static double intervalLevel(int interval) { return interval == 0 ? 0.75 : 0.45; }
+
+    GranularShifter()
+    : mLength(1), mWrite(0), mGrainLength(1), mIncrement(0)
+    {
+        for (int h = 0; h < kNumHeads; h++)
+            mPhase[h] = mSweep[h] = mLevel[h] = 0;
+    }
+
+    // Reserve or assign the history for the given sample rate (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate)
+    {
+        mGrainLength = std::max(4.0, std::floor(kGrainSeconds * sampleRate));
+        mIncrement = (SampleType)(1.0 / mGrainLength);
+
+        // A head's delay falls from (ratio - 1) grains to nothing
+        double longest = 0.0;
+        for (int h = 0; h < kNumHeads; h++) {
+            const int interval = h / 2;
+            const double ratio = std::pow(2.0, intervalSemitones(interval) / 12.0);
+            mSweep[h] = (SampleType)((ratio - 1.0) * mGrainLength);
+            mLevel[h] = (SampleType)intervalLevel(interval);
+            longest = std::max(longest, (double)mSweep[h]);
+        }
+
+        mLength = (Steinberg::int32)longest + kMinDelay + 4;
+        mHistory = arena.allocate<SampleType>(mLength * kNumLanes);
+    }
+
+    // Clear the history without touching the allocation
+    void reset()
+    {
+        mHistory.clear();
+        mWrite = 0;
+
+        // The two heads of an interval half a grain apart, the intervals a
+        // quarter grain apart
+        for (int h = 0; h < kNumHeads; h++)
+            mPhase[h] = (SampleType)(0.5 * (h % 2) + 0.25 * (h / 2));
+    }
+
+    //-------------------------------------------------------------------------
+    // One frame of NumLanes channels: input[lane] in, both intervals mixed
+    // into output[lane]. Cubic reads for offline renders, linear otherwise
+    template <int NumLanes, bool Cubic>
+    void process(const SampleType* input, SampleType* output)
+    {
+        static_assert(NumLanes >= 1 && NumLanes <= kNumLanes, "one lane per channel");
+
+        for (int lane = 0; lane < NumLanes; lane++)
+            mHistory[lane * mLength + mWrite] = input[lane];
+
+        // Advance every head through its grain, and find its delay and gain
+        SampleType delay[kNumHeads], gain[kNumHeads];
+        for (int h = 0; h < kNumHeads; h++) {
+            SampleType phase = mPhase[h] + mIncrement;
+            phase = (phase >= (SampleType)1) ? phase - (SampleType)1 : phase;
+            mPhase[h] = phase;
+
+            delay[h] = (SampleType)kMinDelay + ((SampleType)1 - phase) * mSweep[h];
+
+            const SampleType position = phase * (SampleType)kWindowSize;
+            const int index = (int)position;
+            const SampleType fraction = position - (SampleType)index;
+            const SampleType w0 = (SampleType)kWindow.values[index];
+            const SampleType w1 = (SampleType)kWindow.values[index + 1];
+            gain[h] = (w0 + (w1 - w0) * fraction) * mLevel[h];
+        }
+
+        // Each head reads delay[h] behind the sample just written
+        for (int lane = 0; lane < NumLanes; lane++) {
+            const SampleType* history = mHistory.data + lane * mLength;
+            SampleType sum = 0;
+            for (int h = 0; h < kNumHeads; h++) {
+                const int whole = (int)delay[h];
+                int index = mWrite - whole - 1;
+                index = (index < 0) ? index + mLength : index;
+                const SampleType fraction = (SampleType)1 - (delay[h] - (SampleType)whole);
+                const SampleType value = Cubic ? readCubic(history, mLength, index, fraction)
+                                               : readLinear(history, mLength, index, fraction);
+                sum += value * gain[h];
+            }
+            output[lane] = sum;
+        }
+
+        mWrite = (mWrite + 1 < mLength) ? mWrite + 1 : 0;
+    }
+
+    // Grain length in samples
+    Steinberg::int32 getGrainLength() const { return (Steinberg::int32)mGrainLength; }
+
+private:
+    static constexpr GranularDetail::WindowTable<kWindowSize> kWindow =
+        GranularDetail::buildWindow<kWindowSize>();
+
+    // Input history, one lane after the other, each mLength long
+    ArenaBuffer<SampleType> mHistory;
+    Steinberg::int32 mLength;
+    Steinberg::int32 mWrite;
+
+    double mGrainLength;                        // In samples
+    SampleType mIncrement;                      // Grain phase step per sample
+
+    // Per head: the two heads of the octave, then the two of the fourth
+    alignas(32) SampleType mPhase[kNumHeads];   // Through the grain, 0 to 1
+    alignas(32) SampleType mSweep[kNumHeads];   // Delay at the start of a grain
+    alignas(32) SampleType mLevel[kNumHeads];
+};
+
+} // namespace MyVSTPlugin
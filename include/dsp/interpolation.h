@@ -0,0 +1,39 @@
+#pragma once
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Fractional reads from circular buffers
+//
+// Both read between buffer[index] and buffer[index + 1] at fraction (0 to 1),
+// wrapping around length. Linear interpolation is the lean realtime read; the
+// 4-point cubic (Catmull-Rom) one also reads the neighbours on either side,
+// which keeps modulated and fractional delays free of the high-frequency loss
+// and the zipper noise of linear reads.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+inline SampleType readLinear(const SampleType* buffer, int length, int index, SampleType fraction)
+{
+    int next = (index + 1 == length) ? 0 : index + 1;
+    return buffer[index] * ((SampleType)1 - fraction) + buffer[next] * fraction;
+}
+
+template <typename SampleType>
+inline SampleType readCubic(const SampleType* buffer, int length, int index, SampleType fraction)
+{
+    int prev = (index == 0) ? length - 1 : index - 1;
+    int next = (index + 1 == length) ? 0 : index + 1;
+    int next2 = (next + 1 == length) ? 0 : next + 1;
+
+    SampleType y0 = buffer[prev];
+    SampleType y1 = buffer[index];
+    SampleType y2 = buffer[next];
+    SampleType y3 = buffer[next2];
+
+    SampleType c1 = (SampleType)0.5 * (y2 - y0);
+    SampleType c2 = y0 - (SampleType)2.5 * y1 + (SampleType)2 * y2 - (SampleType)0.5 * y3;
+    SampleType c3 = (SampleType)0.5 * (y3 - y0) + (SampleType)1.5 * (y1 - y2);
+    return ((c3 * fraction + c2) * fraction + c1) * fraction + y1;
+}
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include "pluginterfaces/base/ftypes.h"
+#include <cmath>
+#include <string>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// NamModel: Captured amp from a Neural Amp Modeler (.nam) file
+//
+// Runs the two architectures NAM captures come in: the WaveNet (stacked
+// dilated convolutions with gated activations) and the LSTM. load() parses the
+// file and packs the weights column by column into one aligned arena, each
+// column padded to whole blocks of eight floats (32 bytes: one AVX register,
+// half a cache line), so every column starts aligned and every matrix-vector
+// product is a run of contiguous multiply-adds the compiler vectorizes.
+//
+// load() allocates and belongs on the message thread. Everything process()
+// touches lives in the model's arena, laid out at load time for kMaxChannels
+// channels of up to kMaxBlockSize samples per call. Inference runs in float
+// whatever the host's sample type, like the reference implementation.
+//-----------------------------------------------------------------------------
+class NamModel
+{
+public:
+    static constexpr Steinberg::int32 kMaxChannels = 2;
+    static constexpr Steinberg::int32 kMaxBlockSize = 64;
+
+    // Read a .nam file; returns nullptr with the reason in error
+    static NamModel* load(const char* path, std::string& error);
+
+    // Build a model from the contents of a .nam file
+    static NamModel* parse(const std::string& json, std::string& error);
+
+    virtual ~NamModel() {}
+
+    // Return every channel to the state the capture was trained from and let
+    // the network settle on silence
+    virtual void reset() = 0;
+
+    // Run numSamples (up to kMaxBlockSize) of one channel in place
+    virtual void process(int channel, float* buffer, Steinberg::int32 numSamples) = 0;
+
+    // Rate the capture was trained at (0 when the file does not say)
+    double getSampleRate() const { return mSampleRate; }
+
+    // The network runs sample for sample at whatever rate it is fed, so it
+    // only sounds like the capture at the rate it was trained at. Files that
+    // don't name a rate are taken at their word at any rate
+    bool runsAtRate(double sampleRate) const
+    {
+        return mSampleRate <= 0.0 || std::fabs(mSampleRate - sampleRate) < 0.5;
+    }
+
+    const char* getArchitecture() const { return mArchitecture; }
+
+protected:
+    NamModel(const char* architecture, double sampleRate)
+    : mSampleRate(sampleRate), mArchitecture(architecture) {}
+
+    NamModel(const NamModel&) = delete;
+    NamModel& operator=(const NamModel&) = delete;
+
+    // Weights and state of the network
+    ProcessArena mArena;
+    double mSampleRate;
+    const char* mArchitecture;
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,309 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Oversampler: 2x/4x/8x up- and downsampling through cascaded half-band stages
+//
+// Each stage doubles (or halves) the rate with a linear-phase half-band FIR in
+// polyphase form: every other tap of a half-band filter is zero, so one phase
+// is a short FIR and the other a plain delay. The FIR phase runs on a mirrored
+// history, which keeps each output a single contiguous dot product the compiler
+// vectorizes. The first stage has the narrowest transition band and gets the
+// longest filter; the later ones only have to reject images far above 20 kHz.
+//
+// Up- and downsampling together delay the signal by a whole number of host
+// samples (see getLatencyForFactor), padded at the top rate where needed. The
+// plain delay path keeps that latency when nothing runs at the oversampled rate.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class Oversampler
+{
+public:
+    static constexpr int kMaxFactorLog2 = 3;                  // Up to 8x
+    static constexpr int kMaxFactor = 1 << kMaxFactorLog2;
+    static constexpr int kStageHalfLengths[kMaxFactorLog2] = {24, 6, 4}; // FIR phase holds twice this many taps
+    static constexpr double kKaiserBeta = 7.0;                // Around 70 dB stopband
+
+    // Latency of up- plus downsampling at 2^factorLog2, in host samples
+    static constexpr Steinberg::int32 getLatencyForFactor(int factorLog2)
+    {
+        Steinberg::int32 factor = 1 << factorLog2;
+        Steinberg::int32 topRateSamples = 0;
+        for (int s = 0; s < factorLog2; s++)
+            topRateSamples += 2 * (2 * kStageHalfLengths[s] - 1) * (factor >> (s + 1));
+        return (topRateSamples + factor - 1) / factor;
+    }
+
+    static constexpr Steinberg::int32 kMaxLatency = getLatencyForFactor(kMaxFactorLog2);
+
+    Oversampler() : mFactorLog2(0), mLatency(0), mPadLength(0), mPadPos(0), mDelayPos(0), mFiltersIdle(true) {}
+
+    // Reserve or assign the buffers for the highest factor (see ProcessArena)
+    void layout(ProcessArena& arena, Steinberg::int32 maxBlockSize)
+    {
+        for (int s = 0; s < kMaxFactorLog2; s++) {
+            mStages[s].layout(arena, kStageHalfLengths[s]);
+            mStageBuffers[s] = arena.allocate<SampleType>(maxBlockSize << (s + 1));
+        }
+        mPad = arena.allocate<SampleType>(kMaxFactor);
+        mDelayLine = arena.allocate<SampleType>(kMaxLatency);
+    }
+
+    // Design the filters (once buffers exist) and clear all state
+    void reset()
+    {
+        for (int s = 0; s < kMaxFactorLog2; s++) {
+            mStages[s].design(kStageHalfLengths[s]);
+            mStageBuffers[s].clear();
+        }
+        clearFilters();
+        mDelayLine.clear();
+        mDelayPos = 0;
+    }
+
+    // Oversampling factor as a power of two (0 = off); clears the filters when it changes
+    void setFactor(int factorLog2)
+    {
+        factorLog2 = std::max(0, std::min(factorLog2, kMaxFactorLog2));
+        if (factorLog2 == mFactorLog2)
+            return;
+
+        mFactorLog2 = factorLog2;
+        mLatency = getLatencyForFactor(factorLog2);
+
+        // Pad the cascade at the top rate up to a whole number of host samples
+        Steinberg::int32 topRateSamples = 0;
+        for (int s = 0; s < factorLog2; s++)
+            topRateSamples += 2 * (2 * kStageHalfLengths[s] - 1) * (getFactor() >> (s + 1));
+        mPadLength = mLatency * getFactor() - topRateSamples;
+
+        clearFilters();
+        mDelayLine.clear();
+        mDelayPos = 0;
+    }
+
+    int getFactorLog2() const { return mFactorLog2; }
+    Steinberg::int32 getFactor() const { return 1 << mFactorLog2; }
+    Steinberg::int32 getLatency() const { return mLatency; }
+
+    // Upsample numSamples of buffer; returns numSamples * getFactor() samples to
+    // process in place before downsample(). Without oversampling it returns buffer itself
+    SampleType* upsample(SampleType* buffer, Steinberg::int32 numSamples)
+    {
+        if (mFactorLog2 == 0)
+            return buffer;
+
+        // Filters that sat idle hold stale audio
+        if (mFiltersIdle) {
+            clearFilters();
+            mFiltersIdle = false;
+        }
+
+        // Keep the plain delay path running, so switching over to it is seamless
+        writeDelay(buffer, numSamples);
+
+        const SampleType* input = buffer;
+        for (int s = 0; s < mFactorLog2; s++) {
+            mStages[s].upsample(input, mStageBuffers[s].data, numSamples << s);
+            input = mStageBuffers[s].data;
+        }
+        return mStageBuffers[mFactorLog2 - 1].data;
+    }
+
+    // Bring the block returned by upsample() back to the host rate in buffer
+    void downsample(SampleType* buffer, Steinberg::int32 numSamples)
+    {
+        if (mFactorLog2 == 0)
+            return;
+
+        SampleType* top = mStageBuffers[mFactorLog2 - 1].data;
+        if (mPadLength > 0) {
+            Steinberg::int32 topSamples = numSamples << mFactorLog2;
+            for (Steinberg::int32 i = 0; i < topSamples; i++) {
+                SampleType delayed = mPad[mPadPos];
+                mPad[mPadPos] = top[i];
+                top[i] = delayed;
+                mPadPos = (mPadPos + 1 == mPadLength) ? 0 : mPadPos + 1;
+            }
+        }
+
+        for (int s = mFactorLog2 - 1; s >= 0; s--) {
+            SampleType* output = (s > 0) ? mStageBuffers[s - 1].data : buffer;
+            mStages[s].downsample(mStageBuffers[s].data, output, numSamples << s);
+        }
+    }
+
+    // Delay buffer by the latency without oversampling, for blocks where
+    // nothing runs at the oversampled rate
+    void delay(SampleType* buffer, Steinberg::int32 numSamples)
+    {
+        if (mFactorLog2 == 0)
+            return;
+
+        mFiltersIdle = true;
+        Steinberg::int32 length = mDelayLine.size();
+        for (Steinberg::int32 i = 0; i < numSamples; i++) {
+            Steinberg::int32 readPos = mDelayPos - mLatency;
+            if (readPos < 0)
+                readPos += length;
+            SampleType delayed = mDelayLine[readPos];
+            mDelayLine[mDelayPos] = buffer[i];
+            buffer[i] = delayed;
+            mDelayPos = (mDelayPos + 1 == length) ? 0 : mDelayPos + 1;
+        }
+    }
+
+private:
+    //-------------------------------------------------------------------------
+    // HalfBandStage: One 2x polyphase half-band interpolator and decimator
+    //
+    // For a half-band filter h centred on tap c = 2K - 1, the even taps form
+    // the FIR phase and the odd ones are all zero apart from h[c] = 0.5.
+    // Up- and downsampling each delay by c samples at the higher rate.
+    //-------------------------------------------------------------------------
+    struct HalfBandStage
+    {
+        ArenaBuffer<SampleType> taps;          // Even taps h[0], h[2], ... h[4K - 2]
+        ArenaBuffer<SampleType> upHistory;     // Mirrored input history of the interpolator
+        ArenaBuffer<SampleType> downHistory;   // Mirrored even-sample history of the decimator
+        ArenaBuffer<SampleType> downCentre;    // Odd samples waiting for the centre tap
+        Steinberg::int32 upPos = 0;
+        Steinberg::int32 downPos = 0;
+        Steinberg::int32 centrePos = 0;
+
+        void layout(ProcessArena& arena, int halfLength)
+        {
+            taps = arena.allocate<SampleType>(2 * halfLength);
+            upHistory = arena.allocate<SampleType>(4 * halfLength);
+            downHistory = arena.allocate<SampleType>(4 * halfLength);
+            downCentre = arena.allocate<SampleType>(halfLength);
+        }
+
+        // Kaiser-windowed sinc, normalized to unity gain at DC
+        void design(int halfLength)
+        {
+            if (!taps.data)
+                return;
+
+            const double pi = 3.14159265358979323846;
+            int numTaps = 4 * halfLength - 1;
+            int centre = 2 * halfLength - 1;
+
+            double sum = 0.0;
+            double coeffs[2 * kStageHalfLengths[0]];
+            for (int i = 0; i < 2 * halfLength; i++) {
+                int k = 2 * i;
+                double x = 0.5 * (k - centre);
+                double sinc = std::sin(pi * x) / (pi * x);
+                double r = 2.0 * k / (numTaps - 1) - 1.0;
+                double window = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(kKaiserBeta);
+                coeffs[i] = 0.5 * sinc * window;
+                sum += coeffs[i];
+            }
+            for (int i = 0; i < 2 * halfLength; i++)
+                taps[i] = (SampleType)(0.5 * coeffs[i] / sum);
+        }
+
+        void clear()
+        {
+            upHistory.clear();
+            downHistory.clear();
+            downCentre.clear();
+            upPos = downPos = centrePos = 0;
+        }
+
+        // numInput samples in, 2 * numInput out
+        void upsample(const SampleType* input, SampleType* output, Steinberg::int32 numInput)
+        {
+            const Steinberg::int32 length = taps.size();
+            const Steinberg::int32 halfLength = length / 2;
+            const SampleType* h = taps.data;
+
+            for (Steinberg::int32 m = 0; m < numInput; m++) {
+                // Newest sample first, so window[i] is the input i samples ago
+                upPos = (upPos == 0) ? length - 1 : upPos - 1;
+                upHistory[upPos] = upHistory[upPos + length] = input[m];
+                const SampleType* window = upHistory.data + upPos;
+
+                SampleType sum = 0;
+                for (Steinberg::int32 i = 0; i < length; i++)
+                    sum += h[i] * window[i];
+
+                // Zero stuffing halves the level, the factor 2 restores it
+                output[2 * m] = 2 * sum;
+                output[2 * m + 1] = window[halfLength - 1];
+            }
+        }
+
+        // 2 * numOutput samples in, numOutput out
+        void downsample(const SampleType* input, SampleType* output, Steinberg::int32 numOutput)
+        {
+            const Steinberg::int32 length = taps.size();
+            const Steinberg::int32 halfLength = length / 2;
+            const SampleType* h = taps.data;
+
+            for (Steinberg::int32 m = 0; m < numOutput; m++) {
+                downPos = (downPos == 0) ? length - 1 : downPos - 1;
+                downHistory[downPos] = downHistory[downPos + length] = input[2 * m];
+                const SampleType* window = downHistory.data + downPos;
+
+                SampleType sum = 0;
+                for (Steinberg::int32 i = 0; i < length; i++)
+                    sum += h[i] * window[i];
+
+                // The centre tap sees the odd sample from halfLength pairs ago
+                SampleType centre = downCentre[centrePos];
+                downCentre[centrePos] = input[2 * m + 1];
+                centrePos = (centrePos + 1 == halfLength) ? 0 : centrePos + 1;
+
+                output[m] = sum + (SampleType)0.5 * centre;
+            }
+        }
+
+        static double besselI0(double x)
+        {
+            double sum = 1.0;
+            double term = 1.0;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+    };
+
+    void clearFilters()
+    {
+        for (int s = 0; s < kMaxFactorLog2; s++)
+            mStages[s].clear();
+        mPad.clear();
+        mPadPos = 0;
+    }
+
+    void writeDelay(const SampleType* buffer, Steinberg::int32 numSamples)
+    {
+        Steinberg::int32 length = mDelayLine.size();
+        for (Steinberg::int32 i = 0; i < numSamples; i++) {
+            mDelayLine[mDelayPos] = buffer[i];
+            mDelayPos = (mDelayPos + 1 == length) ? 0 : mDelayPos + 1;
+        }
+    }
+
+    HalfBandStage mStages[kMaxFactorLog2];
+    ArenaBuffer<SampleType> mStageBuffers[kMaxFactorLog2]; // Output of each upsampling stage
+    ArenaBuffer<SampleType> mPad;                           // Top-rate padding delay
+    ArenaBuffer<SampleType> mDelayLine;                     // Plain delay path
+    int mFactorLog2;
+    Steinberg::int32 mLatency;
+    Steinberg::int32 mPadLength;
+    Steinberg::int32 mPadPos;
+    Steinberg::int32 mDelayPos;
+    bool mFiltersIdle;
+};
+
+} // namespace MyVSTPlugin
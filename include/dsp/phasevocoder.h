@@ -0,0 +1,350 @@
+#pragma once
+
+#include "dsp/fft.h"
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// PhaseVocoderShifter: Two-interval STFT pitch shifter, the offline shimmer
+//
+// Every hop, the last frame of input is windowed and transformed. Each bin's
+// phase advance since the previous frame gives its true frequency. An
+// interval stretches the magnitudes up the spectrum by its pitch ratio, and
+// runs each spectral peak on from its new bin's last phase at its frequency
+// times the ratio; the bins around a peak keep their phase relative to it
+// (identity phase locking), so each partial stays one coherent lobe instead
+// of smearing into the phasey wash of a plain vocoder. The two intervals are
+// summed as spectra, turned back into a frame and overlap-added under the
+// same Hann window. Held chords come out as clean transposed partials,
+// without the grain-rate flutter of a time-domain shifter; transients smear
+// over a frame, which the reverb hides anyway.
+//
+// A stereo pair shares one complex transform each way: the left channel is
+// the real part, the right the imaginary part, and their spectra are told
+// apart by conjugate symmetry. Every hop does the same work, two transforms
+// and the per-bin loops, whatever the signal. The frame is about 40 ms,
+// rounded up to a power of two, and kOverlap frames overlap, so a hop is a
+// quarter frame. A frame can only be transformed once its last sample is in,
+// so the output lags the input by the frame size less one (getLatency()).
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class PhaseVocoderShifter
+{
+public:
+    static constexpr int kNumLanes = 2;             // A stereo pair
+    static constexpr int kNumIntervals = 2;         // Octave and fourth
+    static constexpr int kOverlap = 4;              // Frames overlapping a sample; the hop is the frame over this
+    static constexpr double kFrameSeconds = 0.04;   // Shortest frame, before rounding up to a power of two
+
+    // Semitones up and level of each interval, as for the granular shimmer
+    static double intervalSemitones(int interval) { return interval == 0 ? 12.0 : 5.0; }
+    static double intervalLevel(int interval) { return interval == 0 ? 0.75 : 0.45; }
+
+    // Frame size at the given sample rate
+    static Steinberg::int32 getFrameSize(double sampleRate)
+    {
+        Steinberg::int32 size = 4 * kOverlap;
+        while (size < kFrameSeconds * sampleRate)
+            size *= 2;
+        return size;
+    }
+
+    // Samples the output lags the input at the given sample rate
+    static Steinberg::int32 getLatency(double sampleRate) { return getFrameSize(sampleRate) - 1; }
+
+    PhaseVocoderShifter()
+    : mSize(1), mMask(0), mHop(1), mBins(1), mPos(0), mCount(0)
+    {
+        for (int i = 0; i < kNumIntervals; i++)
+            mRatio[i] = mLevel[i] = 0;
+    }
+
+    // Reserve or assign every frame and bin array for the given sample rate
+    // (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate)
+    {
+        mSize = getFrameSize(sampleRate);
+        mMask = mSize - 1;
+        mHop = mSize / kOverlap;
+        mBins = mSize / 2 + 1;
+
+        mFft.layout(arena, mSize);
+        mAnalysisWindow = arena.allocate<SampleType>(mSize);
+        mSynthesisWindow = arena.allocate<SampleType>(mSize);
+
+        // Input ring and overlap-add accumulator per lane, one lane after the other
+        mInput = arena.allocate<SampleType>(mSize * kNumLanes);
+        mOutput = arena.allocate<SampleType>(mSize * kNumLanes);
+
+        // The transform's frame, and the stereo spectrum rebuilt into it
+        mReal = arena.allocate<SampleType>(mSize);
+        mImag = arena.allocate<SampleType>(mSize);
+        mSynthReal = arena.allocate<SampleType>(mBins * kNumLanes);
+        mSynthImag = arena.allocate<SampleType>(mBins * kNumLanes);
+
+        // Analysis per lane and bin, synthesis phase per lane, interval and bin
+        mLastPhase = arena.allocate<SampleType>(mBins * kNumLanes);
+        mSumPhase = arena.allocate<SampleType>(mBins * kNumLanes * kNumIntervals);
+        mMagnitude = arena.allocate<SampleType>(mBins);
+        mFrequency = arena.allocate<SampleType>(mBins);
+        mPeak = arena.allocate<Steinberg::int32>(mBins);
+        mPeakPhase = arena.allocate<SampleType>(mBins);
+
+        for (int i = 0; i < kNumIntervals; i++) {
+            mRatio[i] = (SampleType)std::pow(2.0, intervalSemitones(i) / 12.0);
+            mLevel[i] = (SampleType)intervalLevel(i);
+        }
+    }
+
+    // Fill the windows and transform tables once the arena has handed out the memory
+    void design()
+    {
+        if (!mAnalysisWindow.data)
+            return;
+
+        mFft.design();
+
+        // Periodic Hann on both sides. Squared, kOverlap of them sum to a
+        // constant, which the synthesis window divides out along with the
+        // inverse transform's gain
+        const double pi = 3.14159265358979323846;
+        double sumOfSquares = 0.0;
+        for (Steinberg::int32 i = 0; i < mSize; i++) {
+            const double w = 0.5 - 0.5 * std::cos(2.0 * pi * i / mSize);
+            mAnalysisWindow[i] = (SampleType)w;
+            sumOfSquares += w * w;
+        }
+
+        const double scale = mHop / (sumOfSquares * mSize);
+        for (Steinberg::int32 i = 0; i < mSize; i++)
+            mSynthesisWindow[i] = (SampleType)(mAnalysisWindow[i] * scale);
+    }
+
+    // Clear every frame and phase without touching the allocation
+    void reset()
+    {
+        mInput.clear();
+        mOutput.clear();
+        mLastPhase.clear();
+        mSumPhase.clear();
+        mPos = 0;
+        mCount = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    // One frame of NumLanes channels: input[lane] in, both intervals mixed
+    // into output[lane], getLatency() samples later
+    template <int NumLanes>
+    void process(const SampleType* input, SampleType* output)
+    {
+        static_assert(NumLanes >= 1 && NumLanes <= kNumLanes, "one lane per channel");
+
+        for (int lane = 0; lane < NumLanes; lane++)
+            mInput[lane * mSize + mPos] = input[lane];
+
+        if (++mCount == mHop) {
+            mCount = 0;
+            processFrame<NumLanes>();
+        }
+
+        // The slot just read is next filled by the frame a whole size ahead
+        for (int lane = 0; lane < NumLanes; lane++) {
+            output[lane] = mOutput[lane * mSize + mPos];
+            mOutput[lane * mSize + mPos] = 0;
+        }
+
+        mPos = (mPos + 1) & mMask;
+    }
+
+    Steinberg::int32 getLatency() const { return mSize - 1; }
+
+private:
+    //-------------------------------------------------------------------------
+    // Shift the frame ending at the sample just written, and overlap-add it
+    // from that sample on
+    template <int NumLanes>
+    void processFrame()
+    {
+        const SampleType twoPi = (SampleType)(2.0 * 3.14159265358979323846);
+        const SampleType hopPhase = twoPi / (SampleType)kOverlap; // Advance of bin 1 per hop
+        const Steinberg::int32 oldest = (mPos + 1) & mMask;
+
+        // Window the ring into the frame, oldest sample first, the right
+        // channel (or silence) as the imaginary part
+        const Steinberg::int32 first = mSize - oldest;
+        const SampleType* left = mInput.data;
+        const SampleType* right = mInput.data + (NumLanes > 1 ? mSize : 0);
+        for (Steinberg::int32 i = 0; i < first; i++) {
+            mReal[i] = left[oldest + i] * mAnalysisWindow[i];
+            mImag[i] = (NumLanes > 1) ? right[oldest + i] * mAnalysisWindow[i] : (SampleType)0;
+        }
+        for (Steinberg::int32 i = first; i < mSize; i++) {
+            mReal[i] = left[i - first] * mAnalysisWindow[i];
+            mImag[i] = (NumLanes > 1) ? right[i - first] * mAnalysisWindow[i] : (SampleType)0;
+        }
+
+        mFft.forward(mReal.data, mImag.data);
+
+        for (int lane = 0; lane < NumLanes; lane++) {
+            SampleType* lastPhase = mLastPhase.data + lane * mBins;
+            SampleType* synthReal = mSynthReal.data + lane * mBins;
+            SampleType* synthImag = mSynthImag.data + lane * mBins;
+
+            // Each channel's bin from the packed spectrum, then its magnitude
+            // and the true frequency (in bins) from its phase advance
+            for (Steinberg::int32 k = 0; k < mBins; k++) {
+                const Steinberg::int32 mirror = (mSize - k) & mMask;
+                const SampleType re = (lane == 0) ? (mReal[k] + mReal[mirror]) * (SampleType)0.5
+                                                  : (mImag[k] + mImag[mirror]) * (SampleType)0.5;
+                const SampleType im = (lane == 0) ? (mImag[k] - mImag[mirror]) * (SampleType)0.5
+                                                  : (mReal[mirror] - mReal[k]) * (SampleType)0.5;
+
+                const SampleType phase = std::atan2(im, re);
+                SampleType advance = phase - lastPhase[k] - (SampleType)k * hopPhase;
+                lastPhase[k] = phase;
+                advance -= twoPi * std::floor(advance / twoPi + (SampleType)0.5);
+
+                mMagnitude[k] = std::sqrt(re * re + im * im);
+                mFrequency[k] = (SampleType)k + advance / hopPhase;
+                synthReal[k] = synthImag[k] = 0;
+            }
+
+            // Every bin belongs to the nearest spectral peak: the partial
+            // whose main lobe it is part of
+            findPeaks();
+
+            for (int interval = 0; interval < kNumIntervals; interval++) {
+                SampleType* sumPhase = mSumPhase.data + (lane * kNumIntervals + interval) * mBins;
+                const SampleType ratio = mRatio[interval];
+                const SampleType inverse = (SampleType)1 / ratio;
+
+                // Each peak runs on from the phase its new bin had a hop ago,
+                // at its frequency times the ratio
+                for (Steinberg::int32 k = 0; k < mBins; k++) {
+                    if (mPeak[k] != k)
+                        continue;
+                    const Steinberg::int32 target = std::min((Steinberg::int32)((SampleType)k * ratio + (SampleType)0.5), mBins - 1);
+                    mPeakPhase[k] = sumPhase[target] + mFrequency[k] * ratio * hopPhase;
+                }
+
+                // Every bin takes the magnitude found at its frequency over
+                // the ratio, so the shifted spectrum has no gaps, and keeps
+                // its source bin's phase relative to the source's peak, so
+                // a partial's lobe stays one coherent lobe
+                const SampleType level = mLevel[interval];
+                for (Steinberg::int32 k = 0; k < mBins; k++) {
+                    const SampleType source = (SampleType)k * inverse;
+                    const Steinberg::int32 below = (Steinberg::int32)source;
+                    const SampleType fraction = source - (SampleType)below;
+                    const Steinberg::int32 above = std::min(below + 1, mBins - 1);
+                    const Steinberg::int32 nearest = (fraction < (SampleType)0.5) ? below : above;
+                    const Steinberg::int32 peak = mPeak[nearest];
+
+                    SampleType phase = mPeakPhase[peak] + centredPhase(lastPhase, nearest) - centredPhase(lastPhase, peak);
+                    phase -= twoPi * std::floor(phase / twoPi);
+                    sumPhase[k] = phase;
+
+                    // Odd bins flipped back: the phases are taken about the
+                    // middle of the frame, where a lobe's bins are in phase
+                    SampleType magnitude = mMagnitude[below] + (mMagnitude[above] - mMagnitude[below]) * fraction;
+                    magnitude *= (k & 1) ? -level : level;
+                    synthReal[k] += magnitude * std::cos(phase);
+                    synthImag[k] += magnitude * std::sin(phase);
+                }
+            }
+
+            // DC and Nyquist stay real
+            synthImag[0] = synthImag[mBins - 1] = 0;
+        }
+
+        // Pack the two spectra back into one, each extended by its conjugate
+        // mirror, so the inverse brings back left and right as real and imaginary parts
+        const SampleType* leftReal = mSynthReal.data;
+        const SampleType* leftImag = mSynthImag.data;
+        const SampleType* rightReal = mSynthReal.data + (NumLanes > 1 ? mBins : 0);
+        const SampleType* rightImag = mSynthImag.data + (NumLanes > 1 ? mBins : 0);
+        const SampleType rightScale = (NumLanes > 1) ? (SampleType)1 : (SampleType)0;
+        for (Steinberg::int32 k = 0; k < mBins; k++) {
+            mReal[k] = leftReal[k] - rightImag[k] * rightScale;
+            mImag[k] = leftImag[k] + rightReal[k] * rightScale;
+        }
+        for (Steinberg::int32 k = 1; k < mBins - 1; k++) {
+            mReal[mSize - k] = leftReal[k] + rightImag[k] * rightScale;
+            mImag[mSize - k] = rightReal[k] * rightScale - leftImag[k];
+        }
+
+        mFft.inverse(mReal.data, mImag.data);
+
+        // Overlap-add the frame into the output from the current slot on
+        const Steinberg::int32 untilWrap = mSize - mPos;
+        for (int lane = 0; lane < NumLanes; lane++) {
+            SampleType* output = mOutput.data + lane * mSize;
+            const SampleType* frame = (lane == 0) ? mReal.data : mImag.data;
+            for (Steinberg::int32 i = 0; i < untilWrap; i++)
+                output[mPos + i] += frame[i] * mSynthesisWindow[i];
+            for (Steinberg::int32 i = untilWrap; i < mSize; i++)
+                output[i - untilWrap] += frame[i] * mSynthesisWindow[i];
+        }
+    }
+
+    // Mark each bin with the nearest local maximum of mMagnitude over five
+    // bins. The first bin of the largest magnitude always is one
+    void findPeaks()
+    {
+        Steinberg::int32 previous = -1;
+        for (Steinberg::int32 k = 0; k < mBins; k++) {
+            const SampleType m = mMagnitude[k];
+            bool peak = true;
+            for (Steinberg::int32 j = std::max(0, k - 2); j < k; j++)
+                peak = peak && m > mMagnitude[j];
+            for (Steinberg::int32 j = k + 1; j <= std::min(mBins - 1, k + 2); j++)
+                peak = peak && m >= mMagnitude[j];
+            previous = peak ? k : previous;
+            mPeak[k] = previous;
+        }
+
+        // Back down, taking the next peak up where it is closer
+        Steinberg::int32 next = -1;
+        for (Steinberg::int32 k = mBins - 1; k >= 0; k--) {
+            next = (mPeak[k] == k) ? k : next;
+            if (next >= 0 && (mPeak[k] < 0 || next - k < k - mPeak[k]))
+                mPeak[k] = next;
+        }
+    }
+
+    // Analysis phase of a bin about the middle of the frame
+    static SampleType centredPhase(const SampleType* phase, Steinberg::int32 k)
+    {
+        return (k & 1) ? phase[k] + (SampleType)3.14159265358979323846 : phase[k];
+    }
+
+    Fft<SampleType> mFft;
+    ArenaBuffer<SampleType> mAnalysisWindow;
+    ArenaBuffer<SampleType> mSynthesisWindow;    // Hann scaled for unity overlap-add
+
+    ArenaBuffer<SampleType> mInput;              // Ring of the last frame per lane
+    ArenaBuffer<SampleType> mOutput;             // Overlap-add ring per lane, read and cleared a sample at a time
+    ArenaBuffer<SampleType> mReal, mImag;        // Transform frame
+    ArenaBuffer<SampleType> mSynthReal, mSynthImag; // Shifted spectrum per lane
+
+    ArenaBuffer<SampleType> mLastPhase;          // Analysis phase per lane and bin
+    ArenaBuffer<SampleType> mSumPhase;           // Synthesis phase per lane, interval and bin
+    ArenaBuffer<SampleType> mMagnitude, mFrequency; // One lane's analysis, frequency in bins
+    ArenaBuffer<Steinberg::int32> mPeak;         // One lane's nearest peak per bin
+    ArenaBuffer<SampleType> mPeakPhase;          // One interval's synthesis phase per peak
+
+    Steinberg::int32 mSize;                      // Frame, a power of two
+    Steinberg::int32 mMask;
+    Steinberg::int32 mHop;
+    Steinberg::int32 mBins;                      // Up to and including Nyquist
+    Steinberg::int32 mPos;                       // Ring slot of the next sample
+    Steinberg::int32 mCount;                     // Samples into the current hop
+
+    SampleType mRatio[kNumIntervals];
+    SampleType mLevel[kNumIntervals];
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "public.sdk/source/vst/utility/alignedalloc.h"
+#include "pluginterfaces/base/ftypes.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ArenaBuffer: Non-owning view of an array carved out of a ProcessArena
+//-----------------------------------------------------------------------------
+template <typename T>
+struct ArenaBuffer
+{
+    T* data = nullptr;
+    Steinberg::int32 length = 0;
+
+    T& operator[](Steinberg::int32 index) { return data[index]; }
+    const T& operator[](Steinberg::int32 index) const { return data[index]; }
+
+    Steinberg::int32 size() const { return length; }
+    T* begin() { return data; }
+    T* end() { return data + length; }
+
+    void clear()
+    {
+        if (data)
+            std::fill(begin(), end(), T(0));
+    }
+};
+
+//-----------------------------------------------------------------------------
+// ProcessArena: One aligned allocation holding every buffer the audio thread uses
+//
+// Buffers are laid out in two passes. The measuring pass only adds up sizes,
+// commit() makes the single allocation, and the second pass hands out the real
+// pointers. Both passes run from setupProcessing, so process() never touches
+// the heap. The memory is kept when a later layout fits into it.
+//-----------------------------------------------------------------------------
+class ProcessArena
+{
+public:
+    static constexpr Steinberg::uint32 kAlignment = 64; // Cache line, also enough for any SIMD width
+
+    ProcessArena() : mMemory(nullptr), mCapacity(0), mOffset(0), mMeasuring(true) {}
+    ~ProcessArena() { Steinberg::Vst::aligned_free(mMemory, kAlignment); }
+
+    ProcessArena(const ProcessArena&) = delete;
+    ProcessArena& operator=(const ProcessArena&) = delete;
+
+    // Start the measuring pass
+    void beginLayout()
+    {
+        mOffset = 0;
+        mMeasuring = true;
+    }
+
+    // Reserve (measuring pass) or hand out (second pass) an aligned array
+    template <typename T>
+    ArenaBuffer<T> allocate(Steinberg::int32 length)
+    {
+        ArenaBuffer<T> buffer;
+        buffer.length = std::max<Steinberg::int32>(length, 1);
+
+        size_t bytes = roundUp(sizeof(T) * (size_t)buffer.length);
+        if (!mMeasuring && mMemory)
+            buffer.data = reinterpret_cast<T*>(static_cast<char*>(mMemory) + mOffset);
+        mOffset += bytes;
+        return buffer;
+    }
+
+    // End the measuring pass: allocate if needed and rewind for the second pass
+    bool commit()
+    {
+        size_t required = std::max(mOffset, (size_t)kAlignment);
+        if (required > mCapacity)
+        {
+            Steinberg::Vst::aligned_free(mMemory, kAlignment);
+            mMemory = Steinberg::Vst::aligned_alloc(required, kAlignment);
+            mCapacity = mMemory ? required : 0;
+        }
+
+        mOffset = 0;
+        mMeasuring = false;
+        return mMemory != nullptr;
+    }
+
+    // Free the memory; buffers handed out before are invalid afterwards
+    void release()
+    {
+        Steinberg::Vst::aligned_free(mMemory, kAlignment);
+        mMemory = nullptr;
+        mCapacity = 0;
+        beginLayout();
+    }
+
+    size_t getCapacity() const { return mCapacity; }
+
+private:
+    static size_t roundUp(size_t bytes) { return (bytes + kAlignment - 1) & ~(size_t)(kAlignment - 1); }
+
+    void* mMemory;
+    size_t mCapacity;
+    size_t mOffset;
+    bool mMeasuring;
+};
+
+} // namespace MyVSTPlugin
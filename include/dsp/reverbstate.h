@@ -0,0 +1,130 @@
+#pragma once
+
+#include "dsp/biquad.h"
+#include "dsp/processarena.h"
+#include <algorithm>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ReverbChannelState: Per-channel buffers and filter state of the reverb
+//
+// Every instance owns one of these per channel: the pre-delay and input
+// diffusion ahead of the shared FdnReverb, the shimmer's return into it, and
+// the delays that line the dry signal up with the reverse reverb's
+// convolution and, offline, the phase vocoder's shimmer. Buffer sizes are
+// derived from the real sample rate in layout(), which carves them out of
+// the chain's ProcessArena from setupProcessing, so the audio thread never
+// allocates.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+struct ReverbChannelState
+{
+    // Allpass sizes at the 44.1kHz reference rate
+    static int referenceAllpassLength(int index)
+    {
+        static const int lengths[] = {223, 149}; // Input AP1, AP2
+        return lengths[index];
+    }
+
+    // ===== Pre-delay and input diffusion =====
+    ArenaBuffer<SampleType> preDelayBuffer; // 200ms
+    int preDelayPos;
+    SampleType preDelay;                    // Read tap in samples, gliding with the size
+    bool preDelayPrimed;                    // Cleared by reset: the next tap is taken as is
+
+    ArenaBuffer<SampleType> allpass1;
+    ArenaBuffer<SampleType> allpass2;
+    int ap1pos, ap2pos;
+
+    // ===== Shimmer =====
+    SampleType shimmerReturn;               // Last shifted sample, fed back into the network
+    FilterCascade<OnePoleLanes<SampleType, 1>, 2> shimmerFilter; // Band-limits the return
+
+    // ===== Alignment with the convolution and the phase vocoder =====
+    ArenaBuffer<SampleType> dryAlign;       // Dry signal, delayed by the reverb's latency
+    ArenaBuffer<SampleType> wetAlign;       // Wet signal, delayed by the vocoder's latency (offline only)
+    int dryAlignPos, wetAlignPos;
+
+    // ===== Output anti-aliasing =====
+    OnePoleLanes<SampleType, 1> antiAliasingFilter;
+
+    ReverbChannelState()
+    : preDelayPos(0), preDelay(0.0f), preDelayPrimed(false), ap1pos(0), ap2pos(0), shimmerReturn(0.0f)
+    , dryAlignPos(0), wetAlignPos(0)
+    {
+    }
+
+    // Reserve or assign all buffers for the given sample rate (see ProcessArena),
+    // the alignment delays for up to the given lengths
+    void layout(ProcessArena& arena, double sampleRate, int dryAlignLength, int wetAlignLength)
+    {
+        double scale = sampleRate / 44100.0;
+        auto scaled = [scale](int referenceLength) {
+            return std::max(1, (int)(referenceLength * scale + 0.5));
+        };
+
+        preDelayBuffer = arena.allocate<SampleType>(std::max(2, (int)(sampleRate * 0.2)));
+        allpass1 = arena.allocate<SampleType>(scaled(referenceAllpassLength(0)));
+        allpass2 = arena.allocate<SampleType>(scaled(referenceAllpassLength(1)));
+
+        // The dry ring holds one more sample than its longest delay
+        dryAlign = arena.allocate<SampleType>(dryAlignLength + 1);
+        if (wetAlignLength > 0)
+            wetAlign = arena.allocate<SampleType>(wetAlignLength);
+        else
+            wetAlign = ArenaBuffer<SampleType>();
+    }
+
+    // Voice the fixed lowpasses for the sample rate
+    void design(double sampleRate)
+    {
+        // The lows would circle the shimmer loop unshifted, the highs pile up
+        shimmerFilter[0].setCoefficients(OnePoleCoefficients::highpass(sampleRate, 200.0));
+        shimmerFilter[1].setCoefficients(OnePoleCoefficients::lowpass(sampleRate, 2500.0));
+        antiAliasingFilter.setCoefficients(OnePoleCoefficients::lowpass(sampleRate, 1150.0));
+    }
+
+    // Delay a dry sample by delay samples, up to the length laid out
+    SampleType alignDry(SampleType input, int delay)
+    {
+        const int size = dryAlign.size();
+        dryAlign[dryAlignPos] = input;
+        int readPos = dryAlignPos - delay;
+        readPos = (readPos < 0) ? readPos + size : readPos;
+        dryAlignPos = (dryAlignPos + 1 < size) ? dryAlignPos + 1 : 0;
+        return dryAlign[readPos];
+    }
+
+    // Delay a wet sample by the vocoder's latency (offline only)
+    SampleType alignWet(SampleType input)
+    {
+        SampleType output = wetAlign[wetAlignPos];
+        wetAlign[wetAlignPos] = input;
+        wetAlignPos = (wetAlignPos + 1 < wetAlign.size()) ? wetAlignPos + 1 : 0;
+        return output;
+    }
+
+    // Clear all state without touching the allocation
+    void reset()
+    {
+        preDelayBuffer.clear();
+        allpass1.clear();
+        allpass2.clear();
+
+        preDelayPos = 0;
+        preDelay = 0.0f;
+        preDelayPrimed = false;
+        ap1pos = ap2pos = 0;
+
+        shimmerReturn = 0.0f;
+        shimmerFilter.reset();
+
+        dryAlign.clear();
+        wetAlign.clear();
+        dryAlignPos = wetAlignPos = 0;
+        antiAliasingFilter.reset();
+    }
+};
+
+} // namespace MyVSTPlugin
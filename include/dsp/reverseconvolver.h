@@ -0,0 +1,285 @@
+#pragma once
+
+#include "dsp/fft.h"
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ReverseConvolver: Reverse reverb by partitioned convolution
+//
+// A reverse reverb is a reverb tail played backwards: noise that swells up
+// exponentially from silence and stops dead. The input is convolved with
+// exactly that impulse, so every note swells into itself over the impulse's
+// length and is cut off where the swell ends.
+//
+// The impulse is cut into partitions of one block each, and the input's
+// spectrum for every past block is kept in a frequency domain delay line
+// (uniformly partitioned overlap-save). Each block is one forward transform,
+// a complex multiply-add of every partition's spectrum with its input
+// spectrum, and one inverse transform, so the cost per block is fixed by
+// the impulse's length and known in advance. The output lags the input by
+// one block (getLatency()).
+//
+// The noise is white noise lowpassed into a dark wash, transformed once in
+// design(). Its level over time lives in one gain per partition, so Size
+// only sets how many partitions swell and the gains glide to their new
+// envelope block by block, with no transform and no click. The two channels
+// are two independent noises packed into one complex impulse, left as the
+// real part and right as the imaginary part: convolved with the real mono
+// input, one inverse transform brings back both, decorrelated.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class ReverseConvolver
+{
+public:
+    static constexpr double kPartitionSeconds = 0.01; // Shortest block, before rounding up to a power of two
+    static constexpr double kMaxSeconds = 3.0;        // Longest swell
+    static constexpr double kGlideSeconds = 0.2;      // Time constant of a length change
+    static constexpr double kRangeDb = 60.0;          // The swell rises this far over its length
+    static constexpr double kNoiseCorner = 3500.0;    // Two-pole lowpass on the noise, in Hz
+    static constexpr double kOutputLevel = 0.25;      // RMS of the swell for a full scale white input
+
+    // Block (partition) size at the given sample rate
+    static Steinberg::int32 getBlockSize(double sampleRate)
+    {
+        Steinberg::int32 size = 16;
+        while (size < kPartitionSeconds * sampleRate)
+            size *= 2;
+        return size;
+    }
+
+    // Samples the output lags the input at the given sample rate
+    static Steinberg::int32 getLatency(double sampleRate) { return getBlockSize(sampleRate); }
+
+    ReverseConvolver()
+    : mSampleRate(44100.0), mBlock(1), mSize(2), mMaxPartitions(1), mNumPartitions(1), mActive(0)
+    , mSlot(0), mPos(0), mSnap(true), mGlide(0), mPartitionEnergy(1)
+    {
+    }
+
+    // Reserve or assign the impulse and delay line for the given sample rate
+    // (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate)
+    {
+        mSampleRate = sampleRate;
+        mBlock = getBlockSize(sampleRate);
+        mSize = 2 * mBlock;
+        mMaxPartitions = std::max<Steinberg::int32>(1, (Steinberg::int32)std::ceil(kMaxSeconds * sampleRate / mBlock));
+        mGlide = (SampleType)(1.0 - std::exp(-mBlock / (kGlideSeconds * sampleRate)));
+
+        mFft.layout(arena, mSize);
+
+        // Every partition's spectrum, and every past block's, one after the other
+        mImpulseReal = arena.allocate<SampleType>(mSize * mMaxPartitions);
+        mImpulseImag = arena.allocate<SampleType>(mSize * mMaxPartitions);
+        mInputReal = arena.allocate<SampleType>(mSize * mMaxPartitions);
+        mInputImag = arena.allocate<SampleType>(mSize * mMaxPartitions);
+
+        mGain = arena.allocate<SampleType>(mMaxPartitions);
+        mTarget = arena.allocate<SampleType>(mMaxPartitions);
+
+        // Last two blocks of input, the transform's frame, and the output block
+        mHistory = arena.allocate<SampleType>(mSize);
+        mReal = arena.allocate<SampleType>(mSize);
+        mImag = arena.allocate<SampleType>(mSize);
+        mOutputLeft = arena.allocate<SampleType>(mBlock);
+        mOutputRight = arena.allocate<SampleType>(mBlock);
+    }
+
+    // Build the impulse's partitions once the arena has handed out the memory
+    void design()
+    {
+        if (!mImpulseReal.data)
+            return;
+
+        mFft.design();
+
+        // A fixed seed, so every instance and every render sounds the same
+        unsigned int seed = 0x2545F491u;
+        auto noise = [&seed]() {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return (double)seed / 2147483648.0 - 1.0;
+        };
+
+        const double pi = 3.14159265358979323846;
+        const double step = 1.0 - std::exp(-2.0 * pi * kNoiseCorner / mSampleRate);
+        double left[2] = {}, right[2] = {};
+        double energy = 0.0;
+
+        for (Steinberg::int32 p = 0; p < mMaxPartitions; p++) {
+            SampleType* real = mImpulseReal.data + p * mSize;
+            SampleType* imag = mImpulseImag.data + p * mSize;
+
+            // One block of each noise, zero padded to the transform size
+            for (Steinberg::int32 i = 0; i < mBlock; i++) {
+                left[0] += (noise() - left[0]) * step;
+                left[1] += (left[0] - left[1]) * step;
+                right[0] += (noise() - right[0]) * step;
+                right[1] += (right[0] - right[1]) * step;
+                real[i] = (SampleType)left[1];
+                imag[i] = (SampleType)right[1];
+                energy += left[1] * left[1];
+            }
+            std::fill(real + mBlock, real + mSize, (SampleType)0);
+            std::fill(imag + mBlock, imag + mSize, (SampleType)0);
+
+            // The inverse transform's gain is folded into the spectrum
+            mFft.forward(real, imag);
+            for (Steinberg::int32 k = 0; k < mSize; k++) {
+                real[k] /= (SampleType)mSize;
+                imag[k] /= (SampleType)mSize;
+            }
+        }
+
+        mPartitionEnergy = energy / mMaxPartitions;
+        updateTargets();
+    }
+
+    // Set how long the swell lasts, up to kMaxSeconds
+    void setLength(double seconds)
+    {
+        mNumPartitions = getNumPartitions(seconds);
+        updateTargets();
+    }
+
+    // Clear the delay line; the next block's gains jump to their envelope
+    void reset()
+    {
+        mInputReal.clear();
+        mInputImag.clear();
+        mHistory.clear();
+        mOutputLeft.clear();
+        mOutputRight.clear();
+        mSlot = 0;
+        mPos = 0;
+        mSnap = true;
+    }
+
+    //-------------------------------------------------------------------------
+    // One sample: the mono input in, a block later the stereo swell out
+    void process(SampleType input, SampleType* output)
+    {
+        output[0] = mOutputLeft[mPos];
+        output[1] = mOutputRight[mPos];
+        mHistory[mBlock + mPos] = input;
+
+        if (++mPos == mBlock) {
+            mPos = 0;
+            processBlock();
+        }
+    }
+
+    Steinberg::int32 getLatency() const { return mBlock; }
+
+    // Length in samples a swell of the given seconds takes
+    Steinberg::int32 getLength(double seconds) const { return getNumPartitions(seconds) * mBlock; }
+
+private:
+    // Whole partitions covering the given seconds, up to kMaxSeconds
+    Steinberg::int32 getNumPartitions(double seconds) const
+    {
+        return std::max<Steinberg::int32>(1, std::min<Steinberg::int32>(
+            mMaxPartitions, (Steinberg::int32)std::ceil(seconds * mSampleRate / mBlock)));
+    }
+
+    // Envelope of the swell: from kRangeDb down up to full level at its last
+    // partition, silent after it, scaled to kOutputLevel
+    void updateTargets()
+    {
+        if (!mTarget.data)
+            return;
+
+        // Rising by the same factor from partition to partition
+        const double rise = (mNumPartitions > 1) ? std::pow(10.0, kRangeDb / 20.0 / (mNumPartitions - 1)) : 1.0;
+        double sumOfSquares = 0.0;
+        double gain = 1.0;
+        for (Steinberg::int32 p = mNumPartitions - 1; p >= 0; p--) {
+            sumOfSquares += gain * gain;
+            gain /= rise;
+        }
+
+        const double norm = kOutputLevel / std::sqrt(std::max(1e-30, sumOfSquares * mPartitionEnergy));
+        gain = norm;
+        for (Steinberg::int32 p = mMaxPartitions - 1; p >= 0; p--) {
+            mTarget[p] = (p < mNumPartitions) ? (SampleType)gain : (SampleType)0;
+            gain = (p < mNumPartitions) ? gain / rise : gain;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // Transform the block just in, convolve it with every active partition,
+    // and bring back the next output block
+    void processBlock()
+    {
+        // The newest spectrum goes into the delay line's next slot
+        mSlot = (mSlot + 1 < mMaxPartitions) ? mSlot + 1 : 0;
+        SampleType* inputReal = mInputReal.data + mSlot * mSize;
+        SampleType* inputImag = mInputImag.data + mSlot * mSize;
+        std::copy(mHistory.begin(), mHistory.end(), inputReal);
+        std::fill(inputImag, inputImag + mSize, (SampleType)0);
+        mFft.forward(inputReal, inputImag);
+        std::copy(mHistory.begin() + mBlock, mHistory.end(), mHistory.begin());
+
+        // Glide the gains; the partitions past the last audible one are skipped
+        const SampleType glide = mSnap ? (SampleType)1 : mGlide;
+        mSnap = false;
+        Steinberg::int32 active = 0;
+        for (Steinberg::int32 p = 0; p < mMaxPartitions; p++) {
+            SampleType gain = mGain[p] + (mTarget[p] - mGain[p]) * glide;
+            gain = (mTarget[p] == (SampleType)0 && gain < (SampleType)1e-6) ? (SampleType)0 : gain;
+            mGain[p] = gain;
+            active = (gain > (SampleType)0) ? p + 1 : active;
+        }
+        mActive = active;
+
+        std::fill(mReal.begin(), mReal.end(), (SampleType)0);
+        std::fill(mImag.begin(), mImag.end(), (SampleType)0);
+        Steinberg::int32 slot = mSlot;
+        for (Steinberg::int32 p = 0; p < mActive; p++) {
+            const SampleType* xr = mInputReal.data + slot * mSize;
+            const SampleType* xi = mInputImag.data + slot * mSize;
+            const SampleType* hr = mImpulseReal.data + p * mSize;
+            const SampleType* hi = mImpulseImag.data + p * mSize;
+            const SampleType gain = mGain[p];
+
+            for (Steinberg::int32 k = 0; k < mSize; k++) {
+                mReal[k] += (xr[k] * hr[k] - xi[k] * hi[k]) * gain;
+                mImag[k] += (xr[k] * hi[k] + xi[k] * hr[k]) * gain;
+            }
+
+            slot = (slot > 0) ? slot - 1 : mMaxPartitions - 1;
+        }
+
+        // The second half is the clean part of the circular convolution
+        mFft.inverse(mReal.data, mImag.data);
+        std::copy(mReal.begin() + mBlock, mReal.end(), mOutputLeft.begin());
+        std::copy(mImag.begin() + mBlock, mImag.end(), mOutputRight.begin());
+    }
+
+    Fft<SampleType> mFft;
+    ArenaBuffer<SampleType> mImpulseReal, mImpulseImag; // Spectrum per partition
+    ArenaBuffer<SampleType> mInputReal, mInputImag;     // Spectrum per past block, a ring of mMaxPartitions
+    ArenaBuffer<SampleType> mGain, mTarget;             // Envelope per partition, gliding to the target
+    ArenaBuffer<SampleType> mHistory;                   // The previous block, then the one coming in
+    ArenaBuffer<SampleType> mReal, mImag;               // Accumulated spectrum, then the output frame
+    ArenaBuffer<SampleType> mOutputLeft, mOutputRight;  // Block being played out
+
+    double mSampleRate;
+    Steinberg::int32 mBlock;
+    Steinberg::int32 mSize;                             // Transform size, two blocks
+    Steinberg::int32 mMaxPartitions;
+    Steinberg::int32 mNumPartitions;                    // Partitions in the swell, as set
+    Steinberg::int32 mActive;                           // Partitions still audible while the gains glide
+    Steinberg::int32 mSlot;                             // Delay line slot of the newest block
+    Steinberg::int32 mPos;                              // Sample within the block
+    bool mSnap;                                         // Set by reset: the next gains are taken as is
+    SampleType mGlide;                                  // One-pole step of the gains per block
+    double mPartitionEnergy;                            // Mean energy of a partition's left noise
+};
+
+} // namespace MyVSTPlugin
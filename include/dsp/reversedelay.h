@@ -0,0 +1,133 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ReverseDelay: Reverse echo read backwards straight out of the capture ring
+//
+// Every segmentLength samples a read head starts at the newest captured sample
+// and walks backwards for one segment plus a crossfade. Two heads alternate,
+// so the end of one reversed segment fades into the start of the next with an
+// equal-power crossfade. Nothing is copied or reversed in bulk, so the cost
+// is the same two reads on every sample.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class ReverseDelay
+{
+public:
+    static constexpr double kCrossfadeSeconds = 0.01; // Segment boundary crossfade
+    static constexpr int kNumHeads = 2;
+
+    ReverseDelay() : mWritePos(0), mSegmentCountdown(0) { resetHeads(); }
+
+    // Reserve or assign the buffers for segments up to maxSegmentSeconds (see ProcessArena)
+    void layout(ProcessArena& arena, double sampleRate, double maxSegmentSeconds)
+    {
+        int crossfade = std::max(1, (int)(sampleRate * kCrossfadeSeconds));
+        int maxSegment = (int)(sampleRate * maxSegmentSeconds);
+
+        // A head reads back up to one segment plus crossfade while the writer
+        // moves ahead by the same amount, so the ring holds twice that
+        mBuffer = arena.allocate<SampleType>(2 * (maxSegment + crossfade) + 2);
+        mFade = arena.allocate<SampleType>(crossfade);
+    }
+
+    // Clear all state without touching the allocation
+    void reset()
+    {
+        mBuffer.clear();
+        mWritePos = 0;
+        mSegmentCountdown = 0;
+        resetHeads();
+
+        // Quarter-sine fade-in; read backwards it is the matching fade-out
+        if (mFade.data) {
+            int crossfade = mFade.size();
+            for (int i = 0; i < crossfade; i++)
+                mFade[i] = (SampleType)std::sin(0.5 * 3.14159265358979323846 * (i + 0.5) / crossfade);
+        }
+    }
+
+    // Longest segment the ring can play without reading overwritten audio
+    int getMaxSegmentLength() const { return mBuffer.size() / 2 - mFade.size() - 1; }
+
+    // Returns the reversed signal and captures input plus feedback of it
+    SampleType processSample(SampleType input, SampleType feedback, int segmentLength)
+    {
+        if (--mSegmentCountdown <= 0)
+            startSegment(std::max(1, std::min(segmentLength, getMaxSegmentLength())));
+
+        int bufferLength = mBuffer.size();
+        int crossfade = mFade.size();
+
+        SampleType wet = 0;
+        for (int h = 0; h < kNumHeads; h++)
+        {
+            Head& head = mHeads[h];
+            if (head.remaining <= 0)
+                continue;
+
+            // Fade in over the first crossfade samples, out over the last ones
+            int age = head.length - head.remaining;
+            SampleType gain = 1;
+            if (age < crossfade)
+                gain = mFade[age];
+            else if (head.remaining <= crossfade)
+                gain = mFade[head.remaining - 1];
+
+            wet += mBuffer[head.readPos] * gain;
+
+            head.readPos = (head.readPos == 0) ? bufferLength - 1 : head.readPos - 1;
+            head.remaining--;
+        }
+
+        mBuffer[mWritePos] = input + wet * feedback;
+        mWritePos = (mWritePos + 1) % bufferLength;
+
+        return wet;
+    }
+
+private:
+    struct Head
+    {
+        int readPos;
+        int length;
+        int remaining;
+    };
+
+    void resetHeads()
+    {
+        for (int h = 0; h < kNumHeads; h++)
+            mHeads[h] = {0, 0, 0};
+    }
+
+    // Start a head at the newest captured sample; the next segment starts after
+    // segmentLength samples, which is when this one begins its fade-out
+    void startSegment(int segmentLength)
+    {
+        Head* head = &mHeads[0];
+        for (int h = 1; h < kNumHeads; h++) {
+            if (mHeads[h].remaining < head->remaining)
+                head = &mHeads[h];
+        }
+
+        int bufferLength = mBuffer.size();
+        head->readPos = (mWritePos - 1 + bufferLength) % bufferLength;
+        head->length = segmentLength + mFade.size();
+        head->remaining = head->length;
+
+        mSegmentCountdown = segmentLength;
+    }
+
+    ArenaBuffer<SampleType> mBuffer; // Capture ring, read backwards by the heads
+    ArenaBuffer<SampleType> mFade;   // Equal-power crossfade curve
+    int mWritePos;
+    int mSegmentCountdown;
+    Head mHeads[kNumHeads];
+};
+
+} // namespace MyVSTPlugin
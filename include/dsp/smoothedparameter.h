@@ -0,0 +1,128 @@
+#pragma once
+
+#include "dsp/processarena.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// SmoothedParameter: Per-block ramp towards a target value
+//
+// getBlock() fills the ramp for a whole sub-block at once, so stages read a
+// plain array in their inner loops and carry no smoothing state of their own.
+// Linear ramps move by a fixed step, exponential ramps by a fixed ratio (for
+// strictly positive, gain-like values). Once the target is reached the block
+// holds the constant and later calls return it without touching it.
+//
+// The ramp length is given with every target, so a target reached at the end
+// of an automation slice is interpolated exactly across that slice. Ramps are
+// computed in the sample type of the chain that reads them.
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class SmoothedParameter
+{
+public:
+    enum RampMode
+    {
+        kLinear = 0,
+        kExponential
+    };
+
+    SmoothedParameter(RampMode mode = kLinear)
+    : mMode(mode), mCurrent(0), mTarget(0), mStep(0)
+    , mRemaining(0), mBlockIsConstant(false)
+    {
+    }
+
+    // Reserve or assign the ramp block (see ProcessArena)
+    void layout(ProcessArena& arena, Steinberg::int32 maxBlockSize)
+    {
+        mBlock = arena.allocate<SampleType>(maxBlockSize);
+    }
+
+    // Jump to a value without ramping
+    void setValue(SampleType value)
+    {
+        mCurrent = mTarget = sanitize(value);
+        mRemaining = 0;
+        mBlockIsConstant = false;
+    }
+
+    // Ramp from the current value to the target over rampLength samples;
+    // repeating the current target is free
+    void setTarget(SampleType value, Steinberg::int32 rampLength)
+    {
+        value = sanitize(value);
+        if (value == mTarget)
+            return;
+
+        mTarget = value;
+        mRemaining = std::max<Steinberg::int32>(1, rampLength);
+        mBlockIsConstant = false;
+
+        if (mMode == kExponential)
+            mStep = std::pow(mTarget / mCurrent, (SampleType)1 / (SampleType)mRemaining);
+        else
+            mStep = (mTarget - mCurrent) / (SampleType)mRemaining;
+    }
+
+    bool isSmoothing() const { return mRemaining > 0; }
+    SampleType getTarget() const { return mTarget; }
+    SampleType getCurrent() const { return mCurrent; }
+
+    // Ramp values for the next numSamples (numSamples <= the laid out block size)
+    const SampleType* getBlock(Steinberg::int32 numSamples)
+    {
+        SampleType* block = mBlock.data;
+
+        if (mRemaining <= 0) {
+            if (!mBlockIsConstant) {
+                std::fill(block, block + mBlock.size(), mTarget);
+                mBlockIsConstant = true;
+            }
+            return block;
+        }
+
+        Steinberg::int32 rampSamples = std::min(numSamples, mRemaining);
+        if (mMode == kExponential) {
+            SampleType value = mCurrent;
+            for (Steinberg::int32 n = 0; n < rampSamples; n++) {
+                value *= mStep;
+                block[n] = value;
+            }
+        } else {
+            SampleType start = mCurrent;
+            SampleType step = mStep;
+            for (Steinberg::int32 n = 0; n < rampSamples; n++)
+                block[n] = start + step * (SampleType)(n + 1);
+        }
+
+        mRemaining -= rampSamples;
+        if (mRemaining <= 0) {
+            // Land exactly on the target and hold it for the rest of the block
+            mCurrent = mTarget;
+            std::fill(block + rampSamples, block + numSamples, mTarget);
+        } else {
+            mCurrent = block[rampSamples - 1];
+        }
+        return block;
+    }
+
+private:
+    // Exponential ramps cannot cross or touch zero
+    SampleType sanitize(SampleType value) const
+    {
+        return (mMode == kExponential) ? std::max(value, (SampleType)1.0e-6) : value;
+    }
+
+    RampMode mMode;
+    SampleType mCurrent;
+    SampleType mTarget;
+    SampleType mStep;   // Increment (linear) or ratio (exponential) per sample
+    Steinberg::int32 mRemaining;
+    bool mBlockIsConstant;
+    ArenaBuffer<SampleType> mBlock;
+};
+
+} // namespace MyVSTPlugin
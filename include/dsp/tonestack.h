@@ -0,0 +1,163 @@
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ToneStack: Fender/Marshall passive tone stack as a third order IIR filter
+//
+// The treble, bass and mid pots and their three capacitors form one passive
+// network, so the controls interact the way they do on the amp: bass and
+// treble both pull on the mid scoop, and no setting is ever truly flat. Its
+// analog transfer function is third order, with each coefficient a polynomial
+// in the component values and pot positions (Yeh and Smith, "Discretization
+// of the '59 Fender Bassman Tone Stack", DAFx 2006). design() evaluates them
+// and maps them to the z-plane with the bilinear transform, so the voicing
+// is the same at any sample rate; it only needs to run when a knob or the
+// rate changes.
+//
+// The values are the '59 Bassman's; a Marshall stack is the same circuit with
+// different parts. The filter runs in transposed direct form II, in double
+// precision whatever the chain's sample type (its poles sit close to z = 1 at
+// oversampled rates), with one SIMD lane per channel.
+//-----------------------------------------------------------------------------
+class ToneStack
+{
+public:
+    static constexpr int kNumLanes = 2;                 // A stereo pair
+
+    // Components: treble, bass and mid pots, slope resistor, capacitors
+    static constexpr double kTreblePot = 250e3;
+    static constexpr double kBassPot = 1e6;
+    static constexpr double kMidPot = 25e3;
+    static constexpr double kSlopeResistor = 56e3;
+    static constexpr double kTrebleCapacitor = 250e-12;
+    static constexpr double kBassCapacitor = 20e-9;
+    static constexpr double kMidCapacitor = 20e-9;
+
+    // The passive stack loses 2 to 12 dB with the knobs centred; this puts the
+    // lows and highs back at about unity and leaves the mid scoop below
+    static constexpr double kMakeupGain = 2.0;
+
+    ToneStack()
+    {
+        design(44100.0, 0.5, 0.5, 0.5);
+        reset();
+    }
+
+    // Knob positions from 0 to 1. The bass pot is audio taper, the mid and
+    // treble pots linear
+    void design(double sampleRate, double bass, double mid, double treble)
+    {
+        const double t = std::max(0.0, std::min(treble, 1.0));
+        const double m = std::max(0.0, std::min(mid, 1.0));
+        const double l = std::exp((std::max(0.0, std::min(bass, 1.0)) - 1.0) * 3.4);
+
+        const double r1 = kTreblePot, r2 = kBassPot, r3 = kMidPot, r4 = kSlopeResistor;
+        const double c1 = kTrebleCapacitor, c2 = kBassCapacitor, c3 = kMidCapacitor;
+
+        // Analog coefficients, numerator b1 s + b2 s^2 + b3 s^3 over
+        // 1 + a1 s + a2 s^2 + a3 s^3
+        const double b1 = t * c1 * r1 + m * c3 * r3 + l * (c1 * r2 + c2 * r2) + (c1 * r3 + c2 * r3);
+        const double b2 = t * (c1 * c2 * r1 * r4 + c1 * c3 * r1 * r4)
+                        - m * m * (c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3)
+                        + m * (c1 * c3 * r1 * r3 + c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3)
+                        + l * (c1 * c2 * r1 * r2 + c1 * c2 * r2 * r4 + c1 * c3 * r2 * r4)
+                        + l * m * (c1 * c3 * r2 * r3 + c2 * c3 * r2 * r3)
+                        + (c1 * c2 * r1 * r3 + c1 * c2 * r3 * r4 + c1 * c3 * r3 * r4);
+        const double b3 = l * m * (c1 * c2 * c3 * r1 * r2 * r3 + c1 * c2 * c3 * r2 * r3 * r4)
+                        - m * m * (c1 * c2 * c3 * r1 * r3 * r3 + c1 * c2 * c3 * r3 * r3 * r4)
+                        + m * (c1 * c2 * c3 * r1 * r3 * r3 + c1 * c2 * c3 * r3 * r3 * r4)
+                        + t * c1 * c2 * c3 * r1 * r3 * r4
+                        - t * m * c1 * c2 * c3 * r1 * r3 * r4
+                        + t * l * c1 * c2 * c3 * r1 * r2 * r4;
+        const double a1 = (c1 * r1 + c1 * r3 + c2 * r3 + c2 * r4 + c3 * r4) + m * c3 * r3 + l * (c1 * r2 + c2 * r2);
+        const double a2 = m * (c1 * c3 * r1 * r3 - c2 * c3 * r3 * r4 + c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3)
+                        + l * m * (c1 * c3 * r2 * r3 + c2 * c3 * r2 * r3)
+                        - m * m * (c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3)
+                        + l * (c1 * c2 * r2 * r4 + c1 * c2 * r1 * r2 + c1 * c3 * r2 * r4 + c2 * c3 * r2 * r4)
+                        + (c1 * c2 * r1 * r4 + c1 * c3 * r1 * r4 + c1 * c2 * r3 * r4
+                           + c1 * c2 * r1 * r3 + c1 * c3 * r3 * r4 + c2 * c3 * r3 * r4);
+        const double a3 = l * m * (c1 * c2 * c3 * r1 * r2 * r3 + c1 * c2 * c3 * r2 * r3 * r4)
+                        - m * m * (c1 * c2 * c3 * r1 * r3 * r3 + c1 * c2 * c3 * r3 * r3 * r4)
+                        + m * (c1 * c2 * c3 * r3 * r3 * r4 + c1 * c2 * c3 * r1 * r3 * r3 - c1 * c2 * c3 * r1 * r3 * r4)
+                        + l * c1 * c2 * c3 * r1 * r2 * r4
+                        + c1 * c2 * c3 * r1 * r3 * r4;
+
+        // Bilinear transform, s = k (1 - 1/z) / (1 + 1/z)
+        const double k = 2.0 * sampleRate;
+        const double k2 = k * k;
+        const double k3 = k2 * k;
+
+        const double denominator = 1.0 + a1 * k + a2 * k2 + a3 * k3;
+        const double scale = kMakeupGain / denominator;
+        mB[0] = (b1 * k + b2 * k2 + b3 * k3) * scale;
+        mB[1] = (b1 * k - b2 * k2 - 3.0 * b3 * k3) * scale;
+        mB[2] = (-b1 * k - b2 * k2 + 3.0 * b3 * k3) * scale;
+        mB[3] = (-b1 * k + b2 * k2 - b3 * k3) * scale;
+        mA[0] = (3.0 + a1 * k - a2 * k2 - 3.0 * a3 * k3) / denominator;
+        mA[1] = (3.0 - a1 * k - a2 * k2 + 3.0 * a3 * k3) / denominator;
+        mA[2] = (1.0 - a1 * k + a2 * k2 - a3 * k3) / denominator;
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < 3; i++)
+            for (int lane = 0; lane < kNumLanes; lane++)
+                mState[i][lane] = 0.0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Filter NumLanes channels in place, buffers[lane] for each. The lanes
+    // step together, so each line of the recursion is one vector operation
+    // across the channels
+    template <int NumLanes, typename SampleType>
+    void process(SampleType* const* buffers, Steinberg::int32 numSamples)
+    {
+        static_assert(NumLanes >= 1 && NumLanes <= kNumLanes, "one lane per channel");
+
+        const double b0 = mB[0], b1 = mB[1], b2 = mB[2], b3 = mB[3];
+        const double a1 = mA[0], a2 = mA[1], a3 = mA[2];
+
+        double s1[NumLanes], s2[NumLanes], s3[NumLanes];
+        for (int lane = 0; lane < NumLanes; lane++) {
+            s1[lane] = mState[0][lane];
+            s2[lane] = mState[1][lane];
+            s3[lane] = mState[2][lane];
+        }
+
+        for (Steinberg::int32 n = 0; n < numSamples; n++) {
+            double x[NumLanes], y[NumLanes];
+            for (int lane = 0; lane < NumLanes; lane++)
+                x[lane] = (double)buffers[lane][n];
+
+            for (int lane = 0; lane < NumLanes; lane++) {
+                y[lane] = b0 * x[lane] + s1[lane];
+                s1[lane] = b1 * x[lane] - a1 * y[lane] + s2[lane];
+                s2[lane] = b2 * x[lane] - a2 * y[lane] + s3[lane];
+                s3[lane] = b3 * x[lane] - a3 * y[lane];
+            }
+
+            for (int lane = 0; lane < NumLanes; lane++)
+                buffers[lane][n] = (SampleType)y[lane];
+        }
+
+        for (int lane = 0; lane < NumLanes; lane++) {
+            mState[0][lane] = s1[lane];
+            mState[1][lane] = s2[lane];
+            mState[2][lane] = s3[lane];
+        }
+    }
+
+private:
+    double mB[4];   // Numerator, makeup gain included
+    double mA[3];   // Denominator after the leading 1
+
+    // Transposed direct form II state, the channels side by side
+    alignas(16) double mState[3][kNumLanes];
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,292 @@
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// TriodeStage: 12AX7 common-cathode gain stage as a wave digital filter
+//
+// The classic preamp stage: the plate fed from the supply through the plate
+// resistor and AC-coupled into the next stage's grid resistor, the cathode
+// biased by a resistor with a bypass capacitor. Seen from the tube's
+// plate-cathode port, the plate side (supply || coupling branch) and the
+// cathode side (resistor || capacitor) are two parallel adaptors in series,
+// both adapted, so each reduces to a Thevenin source whose voltage is its
+// reflected wave. The capacitors are trapezoidal, as usual for wave digital
+// filters, and the tube (Koren's 12AX7 model) sits at the root.
+//
+// The root is the one implicit equation: the plate current depends on the
+// plate and grid voltages, which depend on the current through the port
+// resistances. For a given rate it is a function of two known values only,
+// the incident wave and the grid drive, so it is solved once on a 2-D grid and
+// process() interpolates bilinearly. Every sample costs the same four reads
+// and a handful of multiply-adds, with no iteration. The grid depends on the
+// rate alone, so each rate's is solved the first time any instance asks for
+// it and then shared by every instance in the process.
+//
+// Grid current is approximated by a soft limit on positive grid drive, ahead
+// of the tube; the grid circuit itself isn't part of the network.
+//-----------------------------------------------------------------------------
+
+// Capacitor voltages and currents of one channel; rate independent, so the
+// stage carries on seamlessly when the oversampling factor changes
+struct TriodeState
+{
+    double cathodeVoltage;
+    double cathodeCurrent;  // Into the bypass capacitor
+    double couplingVoltage;
+    double couplingCurrent; // Through the coupling capacitor into the load
+};
+
+class TriodeStage
+{
+public:
+    static constexpr int kNumRates = 4;         // Host rate times 1, 2, 4 and 8
+
+    // Circuit
+    static constexpr double kSupplyVoltage = 250.0;
+    static constexpr double kPlateResistor = 100e3;
+    static constexpr double kCathodeResistor = 1.5e3;
+    static constexpr double kCathodeCapacitor = 22e-6;
+    static constexpr double kCouplingCapacitor = 22e-9;
+    static constexpr double kLoadResistor = 1e6;
+
+    // Solver grid: grid drive (volts against the cathode side) by incident
+    // wave. The wave follows the capacitor voltages, which move slowly and
+    // keep it within a few volts of its quiescent value, so the grid spends
+    // its points on the drive
+    static constexpr int kDrivePoints = 257;
+    static constexpr int kWavePoints = 65;
+    static constexpr double kDriveMin = -5.0;   // Past cutoff at any plate voltage
+    static constexpr double kDriveMax = 1.0;    // Ceiling of the grid limiter
+    static constexpr double kWaveMin = 0.5 * kSupplyVoltage;
+    static constexpr double kWaveMax = kSupplyVoltage + 10.0;
+
+    TriodeStage() : mOperatingCurrent(0.0), mOperatingPlate(kSupplyVoltage), mOperatingCathode(0.0) {}
+
+    // Adapt the network to the host rate and each oversampled rate, and take
+    // the tube's grid for each. A rate no instance has used yet is solved
+    // here, iterating per grid point, so this belongs in prepare, never on
+    // the audio thread
+    void design(double sampleRate)
+    {
+        // Quiescent point: capacitors open, grid at 0 V
+        mOperatingCurrent = solve([](double current) {
+            double cathode = current * kCathodeResistor;
+            double plate = kSupplyVoltage - current * kPlateResistor;
+            return current - plateCurrent(-cathode, plate - cathode);
+        }, 0.0, kSupplyVoltage / (kPlateResistor + kCathodeResistor));
+        mOperatingCathode = mOperatingCurrent * kCathodeResistor;
+        mOperatingPlate = kSupplyVoltage - mOperatingCurrent * kPlateResistor;
+
+        for (int r = 0; r < kNumRates; r++)
+            mSolvers[r].design(sampleRate * (1 << r));
+    }
+
+    // Settle a channel at the quiescent point, so nothing thumps on start
+    void reset(TriodeState& state) const
+    {
+        state.cathodeVoltage = mOperatingCathode;
+        state.cathodeCurrent = 0.0;
+        state.couplingVoltage = mOperatingPlate;
+        state.couplingCurrent = 0.0;
+    }
+
+    //-------------------------------------------------------------------------
+    // Run a block in place at host rate times 2^rateLog2: grid voltage in,
+    // voltage across the load out (AC-coupled, tens of volts at full swing)
+    template <typename SampleType>
+    void process(SampleType* buffer, Steinberg::int32 numSamples, int rateLog2, TriodeState& state) const
+    {
+        const Solver& s = mSolvers[std::max(0, std::min(rateLog2, kNumRates - 1))];
+        if (!s.table)
+            return;
+
+        // Capacitor waves for the next sample, from their voltages and currents
+        double cathodeWave = state.cathodeVoltage + s.cathodeCapPort * state.cathodeCurrent;
+        double couplingWave = state.couplingVoltage + s.couplingCapPort * state.couplingCurrent;
+        double cathode = state.cathodeVoltage;
+        double coupling = 0.0;
+
+        for (Steinberg::int32 n = 0; n < numSamples; n++) {
+            // Reflected waves of the two sides (the resistors reflect nothing,
+            // the supply its own voltage)
+            const double cathodeSide = s.cathodeCapWeight * cathodeWave;
+            const double plateSide = s.supplyPart + s.couplingWeight * couplingWave;
+
+            // Grid current holds the grid from swinging far above the cathode
+            double drive = (double)buffer[n] - cathodeSide;
+            drive = (drive > 0.0) ? drive / (1.0 + drive / kDriveMax) : drive;
+
+            const double current = s.lookup(drive, plateSide - cathodeSide);
+
+            // Back down the tree: port voltages, then the capacitors' new waves
+            cathode = cathodeSide + s.cathodePort * current;
+            const double plate = plateSide - s.platePort * current;
+            coupling = (plate - couplingWave) * s.couplingConductance;
+
+            buffer[n] = (SampleType)(coupling * kLoadResistor);
+
+            cathodeWave = 2.0 * cathode - cathodeWave;
+            couplingWave += 2.0 * s.couplingCapPort * coupling;
+        }
+
+        state.cathodeVoltage = cathode;
+        state.cathodeCurrent = (cathodeWave - cathode) / s.cathodeCapPort;
+        state.couplingVoltage = couplingWave - s.couplingCapPort * coupling;
+        state.couplingCurrent = coupling;
+    }
+
+    // Koren's 12AX7 plate current, in amps
+    static double plateCurrent(double gridCathode, double plateCathode)
+    {
+        const double mu = 100.0, ex = 1.4, kg1 = 1060.0, kp = 600.0, kvb = 300.0;
+        if (plateCathode <= 0.0)
+            return 0.0;
+
+        const double e1 = plateCathode / kp
+                        * std::log1p(std::exp(kp * (1.0 / mu + gridCathode / std::sqrt(kvb + plateCathode * plateCathode))));
+        return (e1 > 0.0) ? 2.0 * std::pow(e1, ex) / kg1 : 0.0;
+    }
+
+private:
+    // Root of an increasing function between two bracketing points, by
+    // regula falsi with the Illinois fix; converges in about ten steps
+    template <typename Function>
+    static double solve(Function f, double low, double high)
+    {
+        double fLow = f(low), fHigh = f(high);
+        if (fLow >= 0.0)
+            return low;
+        if (fHigh <= 0.0)
+            return high;
+
+        int side = 0;
+        for (int i = 0; i < 60 && high - low > 1e-13; i++) {
+            const double x = (low * fHigh - high * fLow) / (fHigh - fLow);
+            const double fx = f(x);
+            if (fx == 0.0)
+                return x;
+            if (fx < 0.0) {
+                low = x;
+                fLow = fx;
+                if (side == -1)
+                    fHigh *= 0.5;
+                side = -1;
+            } else {
+                high = x;
+                fHigh = fx;
+                if (side == 1)
+                    fLow *= 0.5;
+                side = 1;
+            }
+        }
+        return (low * fHigh - high * fLow) / (fHigh - fLow);
+    }
+
+    // The network adapted to one rate, and the tube solved for it
+    struct Solver
+    {
+        double cathodeCapPort;      // Port resistances of the capacitors
+        double couplingCapPort;
+        double cathodePort;         // Cathode side: resistor || capacitor
+        double platePort;           // Plate side: supply resistor || coupling branch
+        double cathodeCapWeight;    // Share of the capacitor wave in the cathode side's
+        double couplingWeight;      // ...and of the coupling branch in the plate side's
+        double supplyPart;          // Supply's share of the plate side's wave
+        double couplingConductance; // 1 / (coupling capacitor port + load)
+        double driveScale;          // Grid steps per volt
+        double waveScale;
+
+        std::shared_ptr<const std::vector<float>> grid; // Shared with every solver at this rate
+        const float* table = nullptr; // Plate current, one row of drives per wave
+
+        void design(double rate)
+        {
+            cathodeCapPort = 1.0 / (2.0 * rate * kCathodeCapacitor);
+            couplingCapPort = 1.0 / (2.0 * rate * kCouplingCapacitor);
+
+            const double cathodeConductance = 1.0 / kCathodeResistor;
+            const double cathodeCapConductance = 1.0 / cathodeCapPort;
+            cathodePort = 1.0 / (cathodeConductance + cathodeCapConductance);
+            cathodeCapWeight = cathodeCapConductance * cathodePort;
+
+            const double supplyConductance = 1.0 / kPlateResistor;
+            couplingConductance = 1.0 / (couplingCapPort + kLoadResistor);
+            platePort = 1.0 / (supplyConductance + couplingConductance);
+            couplingWeight = couplingConductance * platePort;
+            supplyPart = kSupplyVoltage * supplyConductance * platePort;
+
+            driveScale = (kDrivePoints - 1) / (kDriveMax - kDriveMin);
+            waveScale = (kWavePoints - 1) / (kWaveMax - kWaveMin);
+
+            grid = getSharedGrid(rate);
+            table = grid->data();
+        }
+
+        // The grid for a rate, solved on first use; the ports are functions
+        // of the rate, so every solver at the rate gets the same one
+        std::shared_ptr<const std::vector<float>> getSharedGrid(double rate) const
+        {
+            static std::mutex mutex;
+            static std::map<double, std::shared_ptr<const std::vector<float>>> grids;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<const std::vector<float>>& shared = grids[rate];
+            if (shared)
+                return shared;
+
+            // Plate current for each grid point: with the port voltages
+            // written out, current = Ip(drive - Rk' current, wave - R0 current),
+            // which has exactly one root between no current and a shorted tube
+            std::vector<float> values(kDrivePoints * kWavePoints);
+            const double rootPort = platePort + cathodePort;
+            for (int w = 0; w < kWavePoints; w++) {
+                const double wave = kWaveMin + w / waveScale;
+                for (int d = 0; d < kDrivePoints; d++) {
+                    const double drive = kDriveMin + d / driveScale;
+                    values[w * kDrivePoints + d] = (float)solve([=](double current) {
+                        return current - plateCurrent(drive - cathodePort * current, wave - rootPort * current);
+                    }, 0.0, wave / rootPort);
+                }
+            }
+
+            shared = std::make_shared<const std::vector<float>>(std::move(values));
+            return shared;
+        }
+
+        double lookup(double drive, double wave) const
+        {
+            double d = (drive - kDriveMin) * driveScale;
+            double w = (wave - kWaveMin) * waveScale;
+            d = std::max(0.0, std::min(d, (double)(kDrivePoints - 1)));
+            w = std::max(0.0, std::min(w, (double)(kWavePoints - 1)));
+
+            const int di = std::min((int)d, kDrivePoints - 2);
+            const int wi = std::min((int)w, kWavePoints - 2);
+            const double df = d - di;
+            const double wf = w - wi;
+
+            const float* row = table + wi * kDrivePoints + di;
+            const double low = row[0] + (row[1] - row[0]) * df;
+            const double high = row[kDrivePoints] + (row[kDrivePoints + 1] - row[kDrivePoints]) * df;
+            return low + (high - low) * wf;
+        }
+    };
+
+    Solver mSolvers[kNumRates];
+
+    // Quiescent point the channels start from
+    double mOperatingCurrent;
+    double mOperatingPlate;
+    double mOperatingCathode;
+};
+
+} // namespace MyVSTPlugin
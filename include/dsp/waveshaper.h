@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// Waveshaper: transfer curves baked into lookup tables at compile time
+//
+// A curve is any type with a constexpr shape(double) over the driven input.
+// WaveshaperTable<Curve> samples it at kTableSize + 1 evenly spaced points on
+// [-kInputRange, kInputRange] while the plugin compiles, so the table lands in
+// the binary's read-only data and loading the plugin costs nothing extra.
+//
+// Lookups interpolate linearly between neighbouring points and hold the end
+// values outside the range. process() has no branches: the index and fraction
+// come from clamped arithmetic and the two reads are plain indexed loads, which
+// the compiler turns into gathers on targets that have them (AVX2 and up), so
+// the block loops around it still vectorize. Every curve costs the same two
+// reads, however involved its shape, so biased or rectified curves with no
+// cheap closed form run as fast as a plain tanh.
+//
+// The first and second antiderivatives of the interpolated curve are tabulated
+// the same way (exactly, from the samples), for antiderivative antialiasing:
+// processAdaa1() and processAdaa2() shape a block from divided differences of
+// the antiderivatives, which suppresses aliasing at the host rate roughly the
+// way 2x to 4x oversampling would.
+//-----------------------------------------------------------------------------
+namespace WaveshaperDetail {
+
+// e^x as (e^(x / 32))^32, the inner power from its degree 11 Taylor polynomial.
+// Good to about 1e-10 relative for |x| <= 18, which is all tanh below needs,
+// and short enough to run a few thousand times per table during compilation
+constexpr double exp(double x)
+{
+    const double r = x / 32.0;
+    double p = 1.0;
+    for (int k = 11; k >= 1; k--)
+        p = 1.0 + p * r / k;
+    for (int k = 0; k < 5; k++)
+        p *= p;
+    return p;
+}
+
+// tanh for building curves; clamped at +-9, where it is 1 to within 3e-8
+constexpr double tanh(double x)
+{
+    x = (x < -9.0) ? -9.0 : (x > 9.0) ? 9.0 : x;
+    const double e = exp(2.0 * x);
+    return (e - 1.0) / (e + 1.0);
+}
+
+// Curve samples, padded with a copy of the last one so a lookup at the very
+// end of the range can still read index + 1
+template <int Size>
+struct alignas(64) Table
+{
+    float values[Size + 2];
+};
+
+template <typename Curve, int Size>
+constexpr Table<Size> buildTable(double inputRange)
+{
+    Table<Size> table{};
+    for (int i = 0; i <= Size; i++)
+        table.values[i] = (float)Curve::shape(-inputRange + 2.0 * inputRange * i / Size);
+    table.values[Size + 1] = table.values[Size];
+    return table;
+}
+
+// Antiderivatives at the table points, zero at the centre. The curve is
+// linear between points, so its first antiderivative is quadratic there and
+// the second cubic, and the sums below are their exact integrals
+template <int Size>
+struct alignas(64) IntegralTable
+{
+    double first[Size + 1];
+    double second[Size + 1];
+};
+
+template <int Size>
+constexpr IntegralTable<Size> buildIntegralTable(const Table<Size>& table, double inputRange)
+{
+    const double step = 2.0 * inputRange / Size;
+    IntegralTable<Size> integrals{};
+    for (int i = 0; i < Size; i++) {
+        const double y = table.values[i];
+        const double slope = table.values[i + 1] - y;
+        integrals.first[i + 1] = integrals.first[i] + step * (y + slope * 0.5);
+        integrals.second[i + 1] = integrals.second[i] + step * integrals.first[i]
+                                + step * step * (y * 0.5 + slope / 6.0);
+    }
+
+    // Shift both to zero at the centre, where the signal spends its time, so
+    // their differences cancel less precision away
+    const int centre = Size / 2;
+    const double first = integrals.first[centre];
+    const double second = integrals.second[centre];
+    for (int i = 0; i <= Size; i++) {
+        integrals.first[i] -= first;
+        integrals.second[i] -= second + first * step * (i - centre);
+    }
+    return integrals;
+}
+
+} // namespace WaveshaperDetail
+
+//-----------------------------------------------------------------------------
+// Antiderivative antialiasing history of one channel
+//-----------------------------------------------------------------------------
+struct WaveshaperAdaaState
+{
+    double lastInput;       // x[n-1]
+    double olderInput;      // x[n-2]
+    double lastIntegral;    // Antiderivative at x[n-1] (first or second, by order)
+    double lastDifference;  // Divided difference over x[n-2], x[n-1] (second order)
+
+    // Curve and order the two values above were computed for. When either
+    // changes they are recomputed from the inputs, as values from another
+    // curve would turn the next divided difference into a spike
+    const void* source;
+
+    void reset()
+    {
+        lastInput = 0.0;
+        olderInput = 0.0;
+        lastIntegral = 0.0;
+        lastDifference = 0.0;
+        source = nullptr;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// 1024 intervals over +-8 fit a table in 4 KB. The interpolation stays within
+// 5e-5 of the distortion's tanh curves and within 2.5e-4 (-72 dB) around the
+// tightest bend, the octave fuzz's rectifier knee. The driven input reaches 5
+// times the signal at full drive; by 8 every curve has flattened out.
+//-----------------------------------------------------------------------------
+template <typename Curve>
+class WaveshaperTable
+{
+public:
+    static constexpr int kTableSize = 1024;       // Intervals
+    static constexpr double kInputRange = 8.0;
+
+    template <typename T>
+    static T process(T x)
+    {
+        T position = (x + (T)kInputRange) * (T)(kTableSize / (2.0 * kInputRange));
+        position = std::max((T)0, std::min(position, (T)kTableSize));
+
+        // position is never negative, so truncation is the floor
+        const int index = (int)position;
+        const T fraction = position - (T)index;
+
+        // Indexing the table itself (not a pointer into it) is what lets the
+        // compiler recognise the reads as gathers
+        const T y0 = (T)kTable.values[index];
+        const T y1 = (T)kTable.values[index + 1];
+        return y0 + (y1 - y0) * fraction;
+    }
+
+    // First and second antiderivatives of what process() computes, held
+    // past the ends the way the curve holds its end values. In double, as
+    // antialiasing divides their differences by small input steps
+    static double integral1(double x)
+    {
+        double excess;
+        const Segment segment = findSegment(x, excess);
+        const double y = segment.value + segment.slope * segment.fraction;
+        return segment.integral1(kStep) + y * excess;
+    }
+
+    static double integral2(double x)
+    {
+        double excess;
+        const Segment segment = findSegment(x, excess);
+        const double y = segment.value + segment.slope * segment.fraction;
+        return segment.integral2(kStep) + segment.integral1(kStep) * excess + y * excess * excess * 0.5;
+    }
+
+    //-------------------------------------------------------------------------
+    // First order antialiasing, in place: the curve averaged over each step of
+    // the input, (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1]). Delays the signal
+    // by half a sample. Steps too small for the division read the curve at
+    // their midpoint instead, which is what the average tends to
+    template <typename T>
+    static void processAdaa1(T* buffer, int numSamples, WaveshaperAdaaState& state)
+    {
+        // Each curve's own table stands for its first order state
+        if (state.source != &kTable) {
+            state.lastIntegral = integral1(state.lastInput);
+            state.source = &kTable;
+        }
+
+        double lastInput = state.lastInput;
+        double olderInput = state.olderInput;
+        double lastIntegral = state.lastIntegral;
+
+        for (int n = 0; n < numSamples; n++) {
+            const double x = buffer[n];
+            const double integral = integral1(x);
+            const double step = x - lastInput;
+
+            if (std::fabs(step) > kAdaa1Tolerance)
+                buffer[n] = (T)((integral - lastIntegral) / step);
+            else
+                buffer[n] = (T)process((x + lastInput) * 0.5);
+
+            olderInput = lastInput;
+            lastInput = x;
+            lastIntegral = integral;
+        }
+
+        state.lastInput = lastInput;
+        state.olderInput = olderInput;
+        state.lastIntegral = lastIntegral;
+    }
+
+    //-------------------------------------------------------------------------
+    // Second order antialiasing, in place: the difference of two successive
+    // divided differences of F2, over the input's span across three samples.
+    // Delays the signal by one sample and attenuates aliasing further than
+    // first order. When the span is too small, the curve's average around
+    // the middle sample is rebuilt from F1 and F2 at the mean of the outer
+    // two (the ill-conditioned case of Bilbao et al., 2017)
+    template <typename T>
+    static void processAdaa2(T* buffer, int numSamples, WaveshaperAdaaState& state)
+    {
+        // ...and its integral table for the second order state
+        if (state.source != &kIntegrals) {
+            state.lastIntegral = integral2(state.lastInput);
+            state.lastDifference = dividedDifference(state.lastInput, state.lastIntegral,
+                                                     state.olderInput, integral2(state.olderInput));
+            state.source = &kIntegrals;
+        }
+
+        double lastInput = state.lastInput;
+        double olderInput = state.olderInput;
+        double lastIntegral = state.lastIntegral;
+        double lastDifference = state.lastDifference;
+
+        for (int n = 0; n < numSamples; n++) {
+            const double x = buffer[n];
+            const double integral = integral2(x);
+
+            const double difference = dividedDifference(x, integral, lastInput, lastIntegral);
+
+            const double span = x - olderInput;
+            double y;
+            if (std::fabs(span) > kAdaa2Tolerance) {
+                y = 2.0 * (difference - lastDifference) / span;
+            } else {
+                const double mean = (x + olderInput) * 0.5;
+                const double offset = mean - lastInput;
+                if (std::fabs(offset) > kAdaa2Tolerance)
+                    y = 2.0 / offset * (integral1(mean) + (lastIntegral - integral2(mean)) / offset);
+                else
+                    y = process((mean + lastInput) * 0.5);
+            }
+            buffer[n] = (T)y;
+
+            olderInput = lastInput;
+            lastInput = x;
+            lastIntegral = integral;
+            lastDifference = difference;
+        }
+
+        state.lastInput = lastInput;
+        state.olderInput = olderInput;
+        state.lastIntegral = lastIntegral;
+        state.lastDifference = lastDifference;
+    }
+
+private:
+    // (F2(a) - F2(b)) / (a - b), or F1 at the midpoint when a and b are too
+    // close for the division
+    static double dividedDifference(double a, double integralA, double b, double integralB)
+    {
+        const double step = a - b;
+        return (std::fabs(step) > kAdaa2Tolerance) ? (integralA - integralB) / step
+                                                   : integral1((a + b) * 0.5);
+    }
+
+    static constexpr double kStep = 2.0 * kInputRange / kTableSize;
+
+    // Input steps below which the divided differences lose too much to
+    // cancellation (second order divides twice, so it needs wider steps);
+    // the fallbacks are accurate to about the square of these
+    static constexpr double kAdaa1Tolerance = 1e-5;
+    static constexpr double kAdaa2Tolerance = 1e-3;
+
+    // The table interval holding x (clamped to the range; excess is how far
+    // beyond the range x lies) and its antiderivatives at the fraction
+    struct Segment
+    {
+        int index;
+        double fraction;
+        double value;
+        double slope;
+
+        double integral1(double step) const
+        {
+            return kIntegrals.first[index] + step * fraction * (value + slope * fraction * 0.5);
+        }
+
+        double integral2(double step) const
+        {
+            return kIntegrals.second[index] + step * fraction * kIntegrals.first[index]
+                 + step * step * fraction * fraction * (value * 0.5 + slope * fraction / 6.0);
+        }
+    };
+
+    static Segment findSegment(double x, double& excess)
+    {
+        const double clamped = std::max(-kInputRange, std::min(x, kInputRange));
+        excess = x - clamped;
+
+        // The last interval also takes the very end of the range
+        const double position = (clamped + kInputRange) / kStep;
+        Segment segment;
+        segment.index = std::min((int)position, kTableSize - 1);
+        segment.fraction = position - segment.index;
+        segment.value = kTable.values[segment.index];
+        segment.slope = kTable.values[segment.index + 1] - segment.value;
+        return segment;
+    }
+
+    static constexpr WaveshaperDetail::Table<kTableSize> kTable =
+        WaveshaperDetail::buildTable<Curve, kTableSize>(kInputRange);
+
+    // Only instantiated by curves that are antialiased
+    static constexpr WaveshaperDetail::IntegralTable<kTableSize> kIntegrals =
+        WaveshaperDetail::buildIntegralTable<kTableSize>(kTable, kInputRange);
+};
+
+} // namespace MyVSTPlugin
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "pluginids.h"
+#include "dsp/processarena.h"
+#include "dsp/biquad.h"
+#include "dsp/delaystate.h"
+#include "dsp/fdnreverb.h"
+#include "dsp/granularshifter.h"
+#include "dsp/nammodel.h"
+#include "dsp/oversampler.h"
+#include "dsp/phasevocoder.h"
+#include "dsp/reverbstate.h"
+#include "dsp/reverseconvolver.h"
+#include "dsp/smoothedparameter.h"
+#include "dsp/tonestack.h"
+#include "dsp/triodestage.h"
+#include "dsp/waveshaper.h"
+#include "pluginterfaces/base/ftypes.h"
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MyVSTPlugin {
+
+//-----------------------------------------------------------------------------
+// ChainParameters: Snapshot of the plugin parameters used by the effect chain
+//-----------------------------------------------------------------------------
+struct ChainParameters
+{
+    // Bypass Parameters (0.0 to 1.0, where >0.5 is bypassed)
+    float ampBypass;
+    float distBypass;
+    float reverbBypass;
+    float delayBypass;
+    float modBypass;
+
+    // Amp Parameters
+    float gain;           // Preamp gain (0.0 to 1.0)
+    float bass;           // Bass EQ (0.0 to 1.0)
+    float mid;            // Mid EQ (0.0 to 1.0)
+    float treble;         // Treble EQ (0.0 to 1.0)
+    float presence;       // Presence (0.0 to 1.0)
+    float outputLevel;    // Output level (0.0 to 1.0)
+    int oversampling;     // Amp and distortion oversampling (0=1x, 1=2x, 2=4x, 3=8x)
+    int ampModel;         // Amp model (0=built-in network, 1=captured .nam model)
+    float cabinet;        // Cabinet simulation (0.0 to 1.0, where >0.5 is on)
+
+    // Distortion Parameters
+    int distType;         // Distortion type (DistortionType)
+    float distDrive;      // Distortion amount (0.0 to 1.0)
+    int distAntialias;    // Distortion antialiasing (0=off, 1=first order ADAA, 2=second order ADAA)
+
+    // Reverb Parameters
+    float reverbMix;      // Reverb mix (0.0 to 1.0)
+    float reverbSize;     // Reverb size/decay (0.0 to 1.0)
+    float reverbReverse;  // Reverse reverb (0.0 to 1.0, where >0.5 is on)
+    float reverbShimmer;  // Shimmer effect amount (0.0 to 1.0)
+
+    // Delay Parameters
+    float delayMix;       // Delay mix (0.0 to 1.0)
+    float delayTime;      // Delay time (0.0 to 1.0, maps to 0.1 to 4.0 seconds)
+    float delayFeedback;  // Delay feedback (0.0 to 1.0)
+    float delayReverse;   // Reverse delay (0.0 to 1.0, where >0.5 is on)
+
+    // Modulation Parameters
+    int modType;          // Modulation type (0=chorus, 1=flanger, 2=phaser)
+    float modRate;        // Modulation rate (0.0 to 1.0)
+    float modDepth;       // Modulation depth (0.0 to 1.0)
+
+    ChainParameters();
+};
+
+//-----------------------------------------------------------------------------
+// EffectChainBase: Constants and coefficient groups shared by every sample type
+//-----------------------------------------------------------------------------
+class EffectChainBase
+{
+public:
+    static constexpr Steinberg::int32 kMaxChannels = 2;    // Per-channel state is kept for stereo
+    static constexpr Steinberg::int32 kSubBlockSize = 64;  // Samples per stage call
+    static constexpr float kTailThreshold = 1.0e-4f;        // -80 dBFS, a tail below it counts as silent
+    static constexpr float kMinShimmer = 0.01f;             // Shimmer amounts up to this leave the shifter out
+
+    // Groups of derived coefficients, marked dirty by the parameter changes
+    // that feed them and recomputed at the start of the next process() call
+    enum CoefficientGroup
+    {
+        kCoeffAmp = 1 << 0,    // Gain
+        kCoeffDist = 1 << 1,   // Drive
+        kCoeffMod = 1 << 2,    // Rate, depth
+        kCoeffDelay = 1 << 3,  // Time, mix, feedback, reverse, bypass (tail length)
+        kCoeffReverb = 1 << 4, // Mix, size, shimmer, reverse, bypass (tail length)
+        kCoeffOutput = 1 << 5, // Output level
+        kCoeffOversampling = 1 << 6, // Oversampling factor (latency, tail length)
+        kCoeffToneStack = 1 << 7, // Bass, mid, treble, presence
+        kCoeffAll = (1 << 8) - 1
+    };
+
+    // Processing quality, picked from ProcessSetup::processMode in setupProcessing
+    enum QualityTier
+    {
+        kQualityRealtime = 0, // Live use: the lean variant of every stage
+        kQualityOffline,      // Offline renders: denser reverb, cubic reads, 8x oversampling
+        kNumQualityTiers
+    };
+
+    // Oversampling factor in use: offline renders always run the highest one
+    static int getEffectiveOversampling(int oversampling, QualityTier quality)
+    {
+        if (quality == kQualityOffline)
+            return Oversampler<float>::kMaxFactorLog2;
+        return std::max(0, std::min(oversampling, Oversampler<float>::kMaxFactorLog2));
+    }
+
+    // Latency the oversampling adds at the given factor (see ChainParameters::oversampling)
+    static Steinberg::int32 getOversamplingLatency(int oversampling, QualityTier quality)
+    {
+        return Oversampler<float>::getLatencyForFactor(getEffectiveOversampling(oversampling, quality));
+    }
+
+    // Echo time for ChainParameters::delayTime: 0.1 to 4.0 seconds
+    static float getDelaySeconds(float delayTime) { return 0.1f + delayTime * 3.9f; }
+
+    // Reverb times for ChainParameters::reverbSize: the network's 60 dB decay
+    // (0.3 to 7.5 seconds), its pre-delay (10 to 25 ms) and line length scale
+    // (1x to 4x), and the reverse swell's length (0.5 to 3 seconds)
+    static float getReverbDecaySeconds(float size) { return 0.3f * std::pow(25.0f, size); }
+    static float getReverbPreDelaySeconds(float size) { return 0.01f * (1.0f + size * 1.5f); }
+    static double getReverbSizeMultiplier(float size) { return 1.0 + size * 3.0; }
+    static double getReverseSwellSeconds(float size) { return 0.5 + size * 2.5; }
+
+    // Share of the shifted tail sent back into the network for
+    // ChainParameters::reverbShimmer; stays below runaway at the largest size
+    static float getShimmerFeedback(float shimmer) { return shimmer * 0.9f; }
+
+    // Latency of the reverb stage: the dry signal waits for the reverse
+    // reverb's convolution (see ChainParameters::reverbReverse) or, offline,
+    // for the phase vocoder's shimmer. Offline it is reported whatever the
+    // mix, shimmer and bypass, which are all automatable, so it holds for the
+    // whole render and the shimmer can fade in at any point of it
+    static Steinberg::int32 getReverbLatency(const ChainParameters& params, double sampleRate, QualityTier quality)
+    {
+        if (params.reverbReverse > 0.5f)
+            return ReverseConvolver<float>::getLatency(sampleRate);
+        if (quality == kQualityOffline)
+            return PhaseVocoderShifter<float>::getLatency(sampleRate);
+        return 0;
+    }
+
+    // Whole latency of the chain, reported to the host
+    static Steinberg::int32 getLatency(const ChainParameters& params, double sampleRate, QualityTier quality)
+    {
+        return getOversamplingLatency(params.oversampling, quality) + getReverbLatency(params, sampleRate, quality);
+    }
+};
+
+//-----------------------------------------------------------------------------
+// EffectChain: Block-oriented stage pipeline (amp -> dist -> mod -> delay -> reverb)
+//
+// Each stage processes a whole sub-block of one channel in place, so bypass
+// and mode decisions are made once per sub-block instead of once per sample
+// and the inner loops are plain array loops the compiler can vectorize.
+// Stages with discrete modes are compiled once per mode. Linked stages (the
+// tone stack and the cabinet) take every channel's sub-block at once and
+// filter the channels side by side, one per SIMD lane, so each stage runs on
+// all channels before the next one starts.
+//
+// The chain is built once per sample type: EffectChain<float> serves 32-bit
+// hosts and EffectChain<double> 64-bit ones, with every buffer, ramp and
+// filter state in that type (both are instantiated in effectchain.cpp).
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+class EffectChain : public EffectChainBase
+{
+public:
+    EffectChain();
+
+    // Lay out every buffer for the sample rate, maximum block size and quality
+    // tier, then reset. Allocates, so call it from setupProcessing only. Returns
+    // false if the arena could not be allocated (the chain then passes audio through).
+    bool prepare(double sampleRate, Steinberg::int32 maxSamplesPerBlock,
+                 QualityTier quality = kQualityRealtime);
+
+    // Give the buffers back until the next prepare(); the chain passes audio
+    // through meanwhile. For the chain of the sample type the host is not using
+    void release();
+
+    // Reset all processing state
+    void reset();
+
+    // Mark coefficient groups for recomputation; call whenever a parameter they
+    // depend on changes (prepare() and reset() mark everything)
+    void invalidate(Steinberg::uint32 groups) { mDirtyGroups |= groups; }
+
+    // Delay and reverb tail for the given settings, in samples (kInfiniteTail
+    // while the echo repeats forever). Taken from the parameters and the
+    // layout alone, so it holds as soon as they are set, before any process()
+    Steinberg::uint32 getTailSamples(const ChainParameters& params) const
+    {
+        Steinberg::int32 gap;
+        return computeTailSamples(params, gap);
+    }
+
+    // True while the output may still be non-silent: after any non-zero input
+    // until the tail has run out or the output stayed below kTailThreshold for
+    // longer than the longest gap between two echoes
+    bool isTailActive() const { return mTailRemaining > 0; }
+
+    // Latency of the oversampling and the reverb, in samples; follows the
+    // factor and reverse mode in use
+    Steinberg::uint32 getLatencySamples() const { return mOversampler[0].getLatency() + mReverbLatency; }
+
+    // Captured amp run when ChainParameters::ampModel selects it (the built-in
+    // network stands in while there is none, or while the host runs at a rate
+    // the capture wasn't trained at). Not owned; only swap it between
+    // process() calls
+    void setAmpModel(NamModel* model) { mAmpModel = model; }
+
+    // Process one host block; inputs and outputs may alias
+    void process(const ChainParameters& params, SampleType** inputs, SampleType** outputs,
+                 Steinberg::int32 numChannels, Steinberg::int32 numSamples);
+
+private:
+    // Stage signatures: processes numSamples of one channel in place, or of
+    // every channel at once for a linked stage
+    typedef void (EffectChain::*StageProc)(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    typedef void (EffectChain::*LinkedStageProc)(SampleType* const* buffers, Steinberg::int32 numChannels,
+                                                 Steinberg::int32 numSamples);
+
+    struct Stage
+    {
+        Stage() : proc(nullptr), name(nullptr), linkedProc(nullptr) {}
+        Stage(StageProc p, const char* n) : proc(p), name(n), linkedProc(nullptr) {}
+        Stage(const char* n, LinkedStageProc l) : proc(nullptr), name(n), linkedProc(l) {}
+
+        StageProc proc;
+        const char* name;
+        LinkedStageProc linkedProc; // Set instead of proc for a linked stage
+    };
+
+    // Captured or built-in amp (and its lowpass), tone stack, distortion,
+    // cabinet, modulation, delay, reverb (or its alignment delay)
+    static constexpr int kMaxStages = 8;
+
+    // Reserve (measuring pass) or assign (second pass) all arena buffers
+    void layoutBuffers();
+
+    // Smoothed parameters; stages read their ramps from mRampBlocks
+    enum RampId
+    {
+        kRampAmpGain = 0,   // Preamp base gain
+        kRampDistDrive,     // Distortion drive factor
+        kRampModDepth,
+        kRampDelayMix,
+        kRampDelayFeedback,
+        kRampReverbMix,     // Raw mix, used by the reverse reverb
+        kRampReverbDry,     // Gain compensated dry level
+        kRampReverbWet,     // Gain compensated wet level
+        kRampOutputLevel,
+        kNumRamps
+    };
+
+    // Values derived from the parameters, valid until their group is invalidated
+    struct Coefficients
+    {
+        // Amp
+        float ampGain;
+        float ampGainFollow;      // Dynamic gain follower step per (oversampled) sample
+
+        // Distortion
+        float distDrive;
+
+        // Modulation
+        float modPhaseIncrement;  // LFO phase step per sample
+        float msToSamples;
+        float modDepth;
+
+        // Delay
+        int delaySamples;         // Echo length, clamped to the line
+        float delayFraction;      // Fractional part of the echo length (offline reads)
+        int reverseSegmentLength; // Reverse delay segment length
+        float delayMix;
+        float delayFeedback;
+
+        // Reverb
+        float reverbMix;
+        float reverbDry;          // Gain compensated dry level
+        float reverbWet;          // Gain compensated wet level
+        float reverbPreDelay;     // Pre-delay in samples
+        float reverbGlide;        // One-pole step of the pre-delay tap towards it
+        float reverbDecay;        // Seconds to fall 60 dB
+        bool shimmer;             // Shifter in the loop (above kMinShimmer)
+        float shimmerAmount;
+        float shimmerFeedback;    // Share of the shifted tail sent back into the network
+
+        // Output
+        float outputLevel;
+    };
+
+    // Recompute the given coefficient groups from the parameter snapshot
+    void updateCoefficients(Steinberg::uint32 groups);
+
+    // Tail length for the given settings, and the longest silent gap inside it
+    Steinberg::uint32 computeTailSamples(const ChainParameters& params, Steinberg::int32& gap) const;
+
+    // Take the tail length and gap of the parameter snapshot for the countdown
+    void updateTailLength();
+
+    // Count the tail down after silent input, cut it short once the output stays quiet
+    void updateTailState(SampleType inputPeak, SampleType outputPeak, Steinberg::int32 numSamples);
+
+    // Set the ramp targets from the coefficients, ramping over numSamples
+    void updateRampTargets(Steinberg::int32 numSamples);
+
+    // Advance every ramp by one sub-block
+    void fillRampBlocks(Steinberg::int32 numSamples);
+
+    // Build the list of active stages for the current block; the stages in
+    // [oversampledBegin, oversampledEnd) run at the oversampled rate
+    Steinberg::int32 buildStageList(Stage* stages, Steinberg::int32& oversampledBegin,
+                                    Steinberg::int32& oversampledEnd) const;
+
+    // Run one stage on a sub-block of every channel, with level logging
+    void runStage(const Stage& stage, SampleType* const* buffers, Steinberg::int32 numChannels,
+                  Steinberg::int32 numSamples);
+
+    // Stage implementations (whole sub-block per call). Discrete modes and the
+    // quality tier are template arguments, so each combination compiles to its
+    // own branch-free kernel and buildStageList() picks it from a dispatch table.
+    // The amp and distortion read their ramps at n >> mRampShift, as they may run oversampled
+    void processAmpBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    void processCapturedAmpBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    void processTriodeAmpBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    template <int DistType, int Antialias>
+    void processDistortionBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    template <int ModType, int Quality>
+    void processModulationBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+    template <bool Reverse, int Quality>
+    void processDelayBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+
+    // Reverb off while it adds latency (reverse mode, or offline): just the
+    // dry alignment, so the reported latency holds
+    void processReverbAlignBlock(SampleType* buffer, Steinberg::int32 numSamples, int channel);
+
+    // Linked stages, on every channel's sub-block at once: the built-in amp's
+    // lowpass and the tone stack (possibly oversampled), cabinet and the
+    // stereo reverb
+    void processAmpLowpassBlock(SampleType* const* buffers, Steinberg::int32 numChannels, Steinberg::int32 numSamples);
+    void processToneStack(SampleType* const* buffers, Steinberg::int32 numChannels, Steinberg::int32 numSamples);
+    void processCabinetBlock(SampleType* const* buffers, Steinberg::int32 numChannels, Steinberg::int32 numSamples);
+    template <bool Reverse, int Quality>
+    void processReverbBlock(SampleType* const* buffers, Steinberg::int32 numChannels, Steinberg::int32 numSamples);
+
+    // Voice the cabinet's filters for the sample rate
+    void designCabinet();
+
+    // Per-sample helpers used inside the block loops
+    template <int Quality>
+    void processComplexReverbFrame(SampleType* frame, Steinberg::int32 numChannels); // One frame of every channel, in place
+
+    // Fractional delay-line read: linear in realtime, cubic offline
+    template <int Quality>
+    static SampleType readInterpolated(const SampleType* buffer, int length, int index, SampleType fraction);
+
+    // Parameter snapshot for the block being processed
+    ChainParameters mParams;
+
+    // Processing state
+    double mSampleRate;
+    Steinberg::int32 mMaxSamplesPerBlock;
+    QualityTier mQuality;
+    bool mPrepared;
+
+    // Single aligned allocation backing every buffer below
+    ProcessArena mArena;
+
+    // Scratch buffers the stages run on, one per channel, so the linked
+    // stages can take the channels side by side
+    ArenaBuffer<SampleType> mScratch[kMaxChannels];
+
+    // Captured amp (see setAmpModel) and the float buffer it runs on
+    NamModel* mAmpModel;
+    ArenaBuffer<float> mModelScratch;
+
+    // Built-in amp network over one (possibly oversampled) sub-block
+    ArenaBuffer<SampleType> mAmpInput;     // Last kAmpTaps - 1 inputs, then the block
+    ArenaBuffer<SampleType> mAmpLayer1;    // Input convolution after its activation
+    ArenaBuffer<SampleType> mAmpDrive;     // Layer 1 scaled by the dynamic gain
+    ArenaBuffer<SampleType> mAmpHarmonic;  // Harmonic term of the recurrent layer
+    ArenaBuffer<SampleType> mAmpLayer2;    // Last kAmpMemory recurrent outputs, then the block
+
+    // Triode amp: the stage with its solved tables, and each channel's capacitors
+    static constexpr SampleType kTriodeGridVolts = 2.0f;      // Grid swing per unit of driven signal
+    static constexpr SampleType kTriodeOutputScale = 0.01f;   // Back from plate volts
+    TriodeStage mTriode;
+    TriodeState mTriodeState[kMaxChannels];
+
+    // Built-in amp's output lowpass, at the rate the network runs: its zeros
+    // at Nyquist stop the recurrent layer's period-two limit cycle, which at
+    // 1x would otherwise swamp the guitar and vanish once oversampled
+    BiquadLanes<SampleType, kMaxChannels> mAmpLowpass;
+
+    // Tone stack after the amp, the channels in its SIMD lanes, and the
+    // presence shelf that follows it
+    ToneStack mToneStack;
+    BiquadLanes<SampleType, kMaxChannels> mPresence;
+
+    // Cabinet: speaker resonance, low rolloff, presence peak, high rolloff
+    FilterCascade<BiquadLanes<SampleType, kMaxChannels>, 4> mCabinet;
+
+    // Derived coefficients and the groups that need recomputing
+    Coefficients mCoeffs;
+    Steinberg::uint32 mDirtyGroups;
+
+    // Tail tracking (see isTailActive)
+    Steinberg::uint32 mTailSamples;    // Current tail length, or kInfiniteTail
+    Steinberg::int32 mTailGap;         // Longest stretch of quiet output inside a tail
+    Steinberg::uint32 mTailRemaining;  // Samples left of the running tail
+    Steinberg::int32 mQuietSamples;    // Consecutive output samples below kTailThreshold
+
+    // Parameter ramps and their values for the current sub-block
+    SmoothedParameter<SampleType> mRampParams[kNumRamps];
+    const SampleType* mRampBlocks[kNumRamps];
+    bool mRampsPrimed;
+
+    // Oversampling around the amp and distortion, one per channel
+    Oversampler<SampleType> mOversampler[kMaxChannels];
+    int mRampShift;                  // log2 of the rate the running stage is at, relative to the ramps
+
+    // Delay lines, one set per channel
+    DelayChannelState<SampleType> mDelayState[kMaxChannels];
+
+    // Reverb state, one per channel around the shared stereo network
+    ReverbChannelState<SampleType> mReverbState[kMaxChannels];
+    FdnReverb<SampleType> mFdn;
+    GranularShifter<SampleType> mShimmer;    // In the network's feedback path
+    PhaseVocoderShifter<SampleType> mVocoderShimmer; // Takes its place offline
+    ReverseConvolver<SampleType> mReverseReverb; // Stands in for the network in reverse mode
+    Steinberg::int32 mReverbLatency;         // Samples the reverb's alignment delays add, see getReverbLatency()
+
+    // DC blockers after the uneven distortion curves, one lane per channel
+    OnePoleLanes<SampleType, kMaxChannels> mDistDcBlocker;
+
+    // Antiderivative antialiasing history of the distortion, one per channel
+    WaveshaperAdaaState mDistAdaaState[kMaxChannels];
+
+    // Modulation LFO phase, one per channel so each advances once per sample
+    SampleType mModPhase[kMaxChannels];
+
+    // Modulation state variables (were static, causing buzzing), per channel
+    SampleType mModGateState[kMaxChannels];    // Modulation noise gate state
+    SampleType mFlangerFeedback[kMaxChannels]; // Flanger feedback state
+    SampleType mPhaserStage1[kMaxChannels];    // Phaser allpass stage 1
+    SampleType mPhaserStage2[kMaxChannels];    // Phaser allpass stage 2
+    SampleType mPhaserStage3[kMaxChannels];    // Phaser allpass stage 3
+    SampleType mPhaserStage4[kMaxChannels];    // Phaser allpass stage 4
+    SampleType mPhaserFeedback[kMaxChannels];  // Phaser feedback state
+
+    // NAM-inspired neural amp modeling state variables
+    static constexpr int kAmpTaps = 8;   // Length of the input convolution
+    static constexpr int kAmpMemory = 4; // Past outputs the recurrent layer remembers
+    SampleType mNeuralHistory[2][kAmpTaps - 1]; // [channels][history_samples] - last inputs, oldest first
+    SampleType mNeuralWeights[3][8];     // [layers][weights] - simplified neural network weights
+    SampleType mNeuralBias[3];           // [layers] - neural network biases
+    SampleType mDynamicGain[2];          // [channels] - dynamic gain adjustment
+    SampleType mMemoryState[2][kAmpMemory]; // [channels][memory] - amp memory simulation, newest first
+};
+
+} // namespace MyVSTPlugin
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "pluginids.h"
+#include "effectchain.h"
 #include "public.sdk/source/vst/vsteditcontroller.h"
 
 namespace MyVSTPlugin {
@@ -36,10 +37,20 @@ public:
     // State handling
     Steinberg::tresult PLUGIN_API getState(Steinberg::IBStream* state) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API setState(Steinberg::IBStream* state) SMTG_OVERRIDE;
+    
+    // Ask the processor to load a .nam file (UTF-8 path); kResultOk once it has
+    Steinberg::tresult loadAmpModel(const char* path);
+
+    // Messages from the processor (processing setup)
+    Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
 
 private:
     // Helper methods
     void setupParameters();
+
+    // Ask the host to re-read the latency if the parameters, rate or quality
+    // tier changed it
+    void updateLatency();
     
     // Bypass Parameters
     float mAmpBypass;
@@ -76,6 +87,24 @@ private:
     int mModType;
     float mModRate;
     float mModDepth;
+    
+    // Quality Parameters
+    int mOversampling;
+    
+    // Amp Model Parameters
+    int mAmpModel;
+    
+    // Distortion Antialiasing Parameters
+    int mDistAntialias;
+    
+    // Cabinet Parameters
+    float mCabinet;
+    
+    // Processing setup, as last sent by the processor, and the latency it
+    // reports for it
+    double mSampleRate;
+    EffectChainBase::QualityTier mQuality;
+    Steinberg::int32 mLatency;
 };
 
 } // namespace MyVSTPlugin
\ No newline at end of file
@@ -54,6 +54,18 @@ enum ParameterIDs {
     kParamModRateId,      // Modulation rate
     kParamModDepthId,     // Modulation depth
     
+    // Quality
+    kParamOversamplingId, // Amp and distortion oversampling (1x, 2x, 4x, 8x)
+    
+    // Amp model
+    kParamAmpModelId,     // Amp model (built-in network, captured .nam model, triode)
+    
+    // Distortion antialiasing
+    kParamDistAntialiasId, // Distortion antialiasing (off, first or second order ADAA)
+    
+    // Cabinet
+    kParamCabinetId,      // Cabinet simulation after the built-in and triode amps (on/off)
+    
     kNumParams
 };
 
@@ -62,9 +74,46 @@ enum DistortionType {
     kDistClean = 0,
     kDistCrunch,
     kDistFuzz,
+    kDistAsymmetric,
+    kDistOctaveFuzz,
     kNumDistTypes
 };
 
+// The order the Type parameter lists the distortion types in. Asymmetric and
+// Octave Fuzz were added after the first three and sit between them, so Clean,
+// Crunch and Fuzz keep the normalized values 0, 0.5 and 1 that existing
+// automation holds. States store the DistortionType itself, which didn't
+// change, so older sessions load as they were saved
+static const int kDistTypeListOrder[kNumDistTypes] = {
+    kDistClean, kDistAsymmetric, kDistCrunch, kDistOctaveFuzz, kDistFuzz
+};
+
+// Distortion type for a normalized Type value
+inline int distTypeFromNormalized(double value)
+{
+    int position = (int)(value * (kNumDistTypes - 1) + 0.5);
+    position = position < 0 ? 0 : (position > kNumDistTypes - 1 ? kNumDistTypes - 1 : position);
+    return kDistTypeListOrder[position];
+}
+
+// Normalized Type value for a distortion type
+inline double distTypeToNormalized(int type)
+{
+    for (int position = 0; position < kNumDistTypes; position++) {
+        if (kDistTypeListOrder[position] == type)
+            return (double)position / (kNumDistTypes - 1);
+    }
+    return 0.0;
+}
+
+// Distortion Antialiasing Values
+enum DistortionAntialiasing {
+    kDistAntialiasOff = 0,
+    kDistAntialiasAdaa1,
+    kDistAntialiasAdaa2,
+    kNumDistAntialiasModes
+};
+
 // Modulation Type Values
 enum ModulationType {
     kModChorus = 0,
@@ -73,4 +122,31 @@ enum ModulationType {
     kNumModTypes
 };
 
+// Oversampling Factor Values
+enum OversamplingFactor {
+    kOversampling1x = 0,
+    kOversampling2x,
+    kOversampling4x,
+    kOversampling8x,
+    kNumOversamplingFactors
+};
+
+// Amp Model Values
+enum AmpModel {
+    kAmpModelBuiltIn = 0,
+    kAmpModelCaptured,
+    kAmpModelTriode,
+    kNumAmpModels
+};
+
+// Controller to processor message carrying the path of a .nam file to load
+static const char* kMsgLoadAmpModel = "LoadAmpModel";
+static const char* kMsgAttrPath = "Path";
+
+// Processor to controller message sent from setupProcessing, so the controller
+// knows the latency the processor will report (see PluginController::updateLatency)
+static const char* kMsgProcessSetup = "ProcessSetup";
+static const char* kMsgAttrSampleRate = "SampleRate";
+static const char* kMsgAttrQuality = "Quality";
+
 } // namespace MyVSTPlugin
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "pluginids.h"
+#include "effectchain.h"
+#include "dsp/nammodel.h"
 #include "public.sdk/source/vst/vstaudioeffect.h"
-#include <vector>
-#include <cmath>
+#include "public.sdk/source/vst/utility/sampleaccurate.h"
+#include <atomic>
+#include <string>
 
 namespace MyVSTPlugin {
 
@@ -33,147 +36,72 @@ public:
     Steinberg::tresult PLUGIN_API setupProcessing(Steinberg::Vst::ProcessSetup& setup) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API canProcessSampleSize(Steinberg::int32 symbolicSampleSize) SMTG_OVERRIDE;
     Steinberg::uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
+    Steinberg::uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
+
+    // Messages from the controller (amp model loading)
+    Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
 
 private:
-    // Bypass Parameters
-    float mAmpBypass;     // Amp bypass (0.0 to 1.0, where >0.5 is bypassed)
-    float mDistBypass;    // Distortion bypass (0.0 to 1.0, where >0.5 is bypassed)
-    float mReverbBypass;  // Reverb bypass (0.0 to 1.0, where >0.5 is bypassed)
-    float mDelayBypass;   // Delay bypass (0.0 to 1.0, where >0.5 is bypassed)
-    float mModBypass;     // Modulation bypass (0.0 to 1.0, where >0.5 is bypassed)
-    
-    // Amp Parameters
-    float mGain;          // Preamp gain (0.0 to 1.0)
-    float mBass;          // Bass EQ (0.0 to 1.0)
-    float mMid;           // Mid EQ (0.0 to 1.0)
-    float mTreble;        // Treble EQ (0.0 to 1.0)
-    float mPresence;      // Presence (0.0 to 1.0)
-    float mOutputLevel;   // Output level (0.0 to 1.0)
-    
-    // Distortion Parameters
-    int mDistType;        // Distortion type (0=clean, 1=crunch, 2=fuzz)
-    float mDistDrive;     // Distortion amount (0.0 to 1.0)
-    
-    // Reverb Parameters
-    float mReverbMix;     // Reverb mix (0.0 to 1.0)
-    float mReverbSize;    // Reverb size/decay (0.0 to 1.0)
-    float mReverbReverse; // Reverse reverb (0.0 to 1.0, where >0.5 is on)
-    float mReverbShimmer; // Shimmer effect amount (0.0 to 1.0)
-    
-    // Delay Parameters
-    float mDelayMix;      // Delay mix (0.0 to 1.0)
-    float mDelayTime;     // Delay time in seconds (0.0 to 2.0)
-    float mDelayFeedback; // Delay feedback (0.0 to 1.0)
-    float mDelayReverse;  // Reverse delay (0.0 to 1.0, where >0.5 is on)
-    
-    // Modulation Parameters
-    int mModType;         // Modulation type (0=chorus, 1=flanger, 2=phaser)
-    float mModRate;       // Modulation rate (0.0 to 1.0)
-    float mModDepth;      // Modulation depth (0.0 to 1.0)
+    // Plugin parameters (bypass, amp, distortion, reverb, delay, modulation)
+    ChainParameters mParams;
 
     // Processing state
     Steinberg::Vst::SampleRate mSampleRate;
     Steinberg::int32 mBypassed;
-    
-    // Delay line for echo effect
-    std::vector<float> mDelayBuffer;
-    std::vector<float> mDelayInputBuffer;  // For reverse delay
-    std::vector<float> mReverseDelayProcessedBuffer; // For processed reverse delay output
-    int mDelayBufferPos;
-    int mDelayInputBufferPos;
-    int mDelayBufferLength;
-    
-    // Reverse delay state variables
-    int mReverseDelayBufferCounter;
-    int mReverseDelayProcessedPos;
-    bool mIsReverseDelayActive;
-    
-    // Reverb buffers and state
-    std::vector<float> mReverbBuffer;
-    std::vector<float> mReverbInputBuffer;  // For reverse reverb
-    std::vector<float> mReverseReverbProcessedBuffer;  // For processed reverse reverb output
-    int mReverbBufferPos;
-    int mReverbInputBufferPos;
-    float mReverbFeedback;
-    
-    // Reverse reverb state variables
-    int mReverseBufferCounter;
-    int mProcessedBufferPos;
-    bool mIsReverseReverbActive;
-    
-    // Modulation state
-    float mModPhase;
-    
-    // Filter state variables for EQ
-    float mBassFilter[2][2];    // [channels][state]
-    float mMidFilter[2][2];     // [channels][state]
-    float mTrebleFilter[2][2];  // [channels][state]
-    float mPresenceFilter[2][2];// [channels][state]
-    
-    // Additional filter states that were causing "bee buzzing" with static variables
-    float mAmpSmoothFilter[2];      // [channels] - amp smoothing per channel
-    float mEqSmoothFilter1[2];      // [channels] - EQ smoothing stage 1
-    float mEqSmoothFilter2[2];      // [channels] - EQ smoothing stage 2
-    float mLowMidFilter[2];         // [channels] - low-mid management
-    float mHighMidFilter[2];        // [channels] - high-mid management
-    float mEqGateState[2];          // [channels] - EQ noise gate state
-    float mGateState[2];            // [channels] - amp noise gate state
-    
-    // Distortion state variables (were static, causing buzzing)
-    float mDistGateState;           // Distortion noise gate state
-    float mDistortionSmoothFilter1; // Distortion smoothing stage 1
-    float mDistortionSmoothFilter2; // Distortion smoothing stage 2
-    float mFuzzSmoother;            // Fuzz effect smoother
-    
-    // Modulation state variables (were static, causing buzzing)
-    float mModGateState;            // Modulation noise gate state
-    float mLfoSmoother;             // LFO smoothing
-    float mModSmoothFilter1;        // Modulation smoothing stage 1
-    float mModSmoothFilter2;        // Modulation smoothing stage 2
-    float mFlangerFeedback;         // Flanger feedback state
-    float mPhaserStage1;            // Phaser allpass stage 1
-    float mPhaserStage2;            // Phaser allpass stage 2
-    float mPhaserStage3;            // Phaser allpass stage 3
-    float mPhaserStage4;            // Phaser allpass stage 4
-    float mPhaserFeedback;          // Phaser feedback state
-    
-    // New tube-style amp simulation state variables
-    float mTubePreampState[2];      // [channels] - tube preamp state
-    float mToneStackLowpass[2];     // [channels] - tone stack lowpass filter
-    float mToneStackHighpass[2];    // [channels] - tone stack highpass filter
-    float mToneStackMidband[2];     // [channels] - tone stack midband filter
-    float mCabinetFilter1[2];       // [channels] - cabinet simulation stage 1
-    float mCabinetFilter2[2];       // [channels] - cabinet simulation stage 2
-    float mCabinetFilter3[2];       // [channels] - cabinet simulation stage 3
-    float mSpeakerResonance[2];     // [channels] - speaker resonance simulation
-    float mTubeCompressionState[2]; // [channels] - tube compression envelope
-    float mInputHighpass[2];        // [channels] - input highpass filter
-    float mOutputLowpass[2];        // [channels] - output anti-aliasing filter
-    
-    // NAM-inspired neural amp modeling state variables
-    float mNeuralHistory[2][8];     // [channels][history_samples] - input history for neural processing
-    float mNeuralWeights[3][8];     // [layers][weights] - simplified neural network weights
-    float mNeuralBias[3];           // [layers] - neural network biases
-    float mNeuralActivation[2][3];  // [channels][layers] - neural activation states
-    int mHistoryIndex[2];           // [channels] - circular buffer index for history
-    float mDynamicGain[2];          // [channels] - dynamic gain adjustment
-    float mMemoryState[2][4];       // [channels][memory] - amp memory simulation
-    
-    // Helper methods for audio processing
-    float processAmp(float input, int channel);
-    float processDistortion(float input);
-    float processEQ(float input, int channel);
-    float processReverb(float input);
-    float processComplexReverbSample(float input); // Advanced reverb algorithm
-    float processDelay(float input);
-    float processModulation(float input);
-    
-    // New tube amp simulation helper methods
-    float processToneStack(float input, int channel);
-    float processCabinetSimulation(float input, int channel);
+    Steinberg::int32 mSampleSize;   // kSample32 or kSample64, from setupProcessing
+    EffectChainBase::QualityTier mQuality; // Offline tier while the host renders offline
+
+    // Block-oriented effect chain that does the actual DSP, one build per
+    // sample size; only the one the host uses holds buffers
+    EffectChain<float> mEffectChain32;
+    EffectChain<double> mEffectChain64;
+
+    // Sample-accurate automation, indexed by parameter ID
+    Steinberg::Vst::SampleAccurate::Parameter mAutomation[kNumParams];
+    Steinberg::Vst::IParamValueQueue* mAutomatedQueues[kNumParams];
+    Steinberg::int32 mNextAutomationPoint[kNumParams];    // Next queue point not yet behind the slice
+    Steinberg::Vst::ParamID mAutomatedParams[kNumParams]; // IDs with changes in this block
+    Steinberg::int32 mNumAutomatedParams;
+    
+    // Captured amp. Models are loaded on the message thread and handed to the
+    // audio thread through mIncomingModel; the one it replaces comes back
+    // through mRetiredModel and is deleted on the message thread
+    NamModel* mAmpModel;                      // In use, owned by the audio thread
+    std::atomic<NamModel*> mIncomingModel;    // Loaded, not yet picked up
+    std::atomic<NamModel*> mRetiredModel;     // Replaced, waiting to be deleted
+    std::string mAmpModelPath;                // File of the last model loaded
+    double mAmpModelRate;                     // Rate it was trained at (0 if the file doesn't say)
+
+    // Load a .nam file and hand it to the audio thread (message thread only)
+    bool loadAmpModel(const char* path);
+
+    // Warn when the host rate isn't the capture's, which leaves the built-in
+    // network standing in for it
+    void checkAmpModelRate() const;
+
+    // Swap in a newly loaded model (audio thread, start of each block)
+    void pickUpAmpModel();
     
     // Reset all processing state
     void resetProcessingBuffers();
+
+    // Run one block through the chain built for the host's sample size
+    template <typename SampleType>
+    void processAudio(Steinberg::Vst::ProcessData& data, EffectChain<SampleType>& chain,
+                      SampleType** inputBuffers, SampleType** outputBuffers);
+
+    // Automation: queues are read once per block, then advanced slice by slice
+    void beginParameterChanges(Steinberg::Vst::IParameterChanges* changes);
+    Steinberg::int32 getNextSliceEnd(Steinberg::int32 offset, Steinberg::int32 numSamples);
+    void advanceParameters(Steinberg::int32 numSamples);
+    void endParameterChanges();
+
+    // Mark derived coefficients of both chains for recomputation
+    void invalidateCoefficients(Steinberg::uint32 groups);
+
+    // Store a normalized parameter value / read it back
+    void applyParameter(Steinberg::Vst::ParamID id, Steinberg::Vst::ParamValue value);
+    Steinberg::Vst::ParamValue getNormalizedParameter(Steinberg::Vst::ParamID id) const;
 };
 
 } // namespace MyVSTPlugin
\ No newline at end of file
@@ -0,0 +1,1528 @@
+#include "effectchain.h"
+#include "dsp/fastmath.h"
+#include "dsp/interpolation.h"
+#include "vstlogger.h"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+using namespace Steinberg;
+using namespace MyVSTPlugin;
+
+// Captured amps run on the chain's sub-blocks, one state per channel
+static_assert(EffectChainBase::kSubBlockSize <= NamModel::kMaxBlockSize, "sub-blocks must fit the amp model");
+static_assert(EffectChainBase::kMaxChannels <= NamModel::kMaxChannels, "channels must fit the amp model");
+static_assert(Oversampler<float>::kMaxFactorLog2 < TriodeStage::kNumRates, "every oversampling rate needs its triode tables");
+static_assert(EffectChainBase::kMaxChannels <= ToneStack::kNumLanes, "every channel needs a tone stack lane");
+
+// Constants for effects
+const float PI = 3.14159265358979323846f;
+const float TWO_PI = 2.0f * PI;
+
+//-----------------------------------------------------------------------------
+ChainParameters::ChainParameters()
+: ampBypass(0.0f)
+, distBypass(0.0f)
+, reverbBypass(0.0f)
+, delayBypass(0.0f)
+, modBypass(0.0f)
+, gain(0.5f)
+, bass(0.5f)
+, mid(0.5f)
+, treble(0.5f)
+, presence(0.5f)
+, outputLevel(0.7f)
+, oversampling(kOversampling1x)
+, ampModel(kAmpModelBuiltIn)
+, cabinet(0.0f)
+, distType(kDistCrunch)
+, distDrive(0.5f)
+, distAntialias(kDistAntialiasOff)
+, reverbMix(0.3f)
+, reverbSize(0.5f)
+, reverbReverse(0.0f)
+, reverbShimmer(0.0f)
+, delayMix(0.3f)
+, delayTime(0.5f)
+, delayFeedback(0.3f)
+, delayReverse(0.0f)
+, modType(kModChorus)
+, modRate(0.5f)
+, modDepth(0.5f)
+{
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+EffectChain<SampleType>::EffectChain()
+: mSampleRate(44100.0)
+, mMaxSamplesPerBlock(kSubBlockSize)
+, mQuality(kQualityRealtime)
+, mPrepared(false)
+, mAmpModel(nullptr)
+, mDirtyGroups(kCoeffAll)
+, mTailSamples(0)
+, mTailGap(0)
+, mTailRemaining(0)
+, mQuietSamples(0)
+, mRampsPrimed(false)
+, mRampShift(0)
+, mReverbLatency(0)
+{
+    // Initialize neural network weights and biases (simplified amp model)
+    // Layer 1: Input processing
+    mNeuralWeights[0][0] = 0.8f;  mNeuralWeights[0][1] = -0.3f; mNeuralWeights[0][2] = 0.6f;  mNeuralWeights[0][3] = -0.2f;
+    mNeuralWeights[0][4] = 0.4f;  mNeuralWeights[0][5] = -0.7f; mNeuralWeights[0][6] = 0.5f;  mNeuralWeights[0][7] = -0.1f;
+
+    // Layer 2: Nonlinear processing
+    mNeuralWeights[1][0] = 1.2f;  mNeuralWeights[1][1] = -0.8f; mNeuralWeights[1][2] = 0.9f;  mNeuralWeights[1][3] = -0.4f;
+    mNeuralWeights[1][4] = 0.7f;  mNeuralWeights[1][5] = -0.6f; mNeuralWeights[1][6] = 1.1f;  mNeuralWeights[1][7] = -0.3f;
+
+    // Layer 3: Output shaping
+    mNeuralWeights[2][0] = 0.9f;  mNeuralWeights[2][1] = -0.5f; mNeuralWeights[2][2] = 0.8f;  mNeuralWeights[2][3] = -0.2f;
+    mNeuralWeights[2][4] = 0.6f;  mNeuralWeights[2][5] = -0.4f; mNeuralWeights[2][6] = 0.7f;  mNeuralWeights[2][7] = -0.1f;
+
+    // Biases
+    mNeuralBias[0] = 0.1f;
+    mNeuralBias[1] = -0.05f;
+    mNeuralBias[2] = 0.02f;
+
+    // Drive is a gain factor, so it ramps exponentially; everything else linearly
+    mRampParams[kRampDistDrive] = SmoothedParameter<SampleType>(SmoothedParameter<SampleType>::kExponential);
+
+    // Buffers come from prepare(), once the host has picked a sample type
+    release();
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+bool EffectChain<SampleType>::prepare(double sampleRate, int32 maxSamplesPerBlock, QualityTier quality)
+{
+    mSampleRate = sampleRate;
+    mMaxSamplesPerBlock = std::max<int32>(1, maxSamplesPerBlock);
+    mQuality = quality;
+
+    // Measure everything, allocate once, then hand out the real buffers
+    mArena.beginLayout();
+    layoutBuffers();
+    mPrepared = mArena.commit();
+    layoutBuffers();
+
+    // Adapt the triode to each oversampling rate (its tables are shared by
+    // every instance and only solved for a rate none has used yet), and
+    // voice the fixed filters for the rate
+    if (mPrepared) {
+        mTriode.design(mSampleRate);
+        designCabinet();
+        for (int i = 0; i < kMaxChannels; i++)
+            mReverbState[i].design(mSampleRate);
+        mVocoderShimmer.design();
+        mReverseReverb.design();
+    }
+
+    reset();
+    return mPrepared;
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::release()
+{
+    // A measuring pass without memory leaves every buffer empty
+    mArena.release();
+    layoutBuffers();
+    mPrepared = false;
+
+    reset();
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::layoutBuffers()
+{
+    // The stages run on sub-blocks, so the scratch never needs more than one
+    for (int i = 0; i < kMaxChannels; i++)
+        mScratch[i] = mArena.allocate<SampleType>(std::min(mMaxSamplesPerBlock, kSubBlockSize));
+    int32 subBlockSize = mScratch[0].size();
+
+    // The captured amp runs in float on host-rate sub-blocks
+    mModelScratch = mArena.allocate<float>(subBlockSize);
+
+    // The built-in amp runs on sub-blocks at up to the highest oversampling rate
+    int32 ampBlockSize = subBlockSize << Oversampler<SampleType>::kMaxFactorLog2;
+    mAmpInput = mArena.allocate<SampleType>(kAmpTaps - 1 + ampBlockSize);
+    mAmpLayer1 = mArena.allocate<SampleType>(ampBlockSize);
+    mAmpDrive = mArena.allocate<SampleType>(ampBlockSize);
+    mAmpHarmonic = mArena.allocate<SampleType>(ampBlockSize);
+    mAmpLayer2 = mArena.allocate<SampleType>(kAmpMemory + ampBlockSize);
+
+    // One ramp block per smoothed parameter, shared by both channels
+    for (int i = 0; i < kNumRamps; i++)
+        mRampParams[i].layout(mArena, subBlockSize);
+
+    // The reverb delays its dry signal to wait for the reverse reverb's
+    // convolution or, offline, for the phase vocoder's shimmer, which its
+    // unshifted wet signal waits for too
+    mReverbLatency = getReverbLatency(mParams, mSampleRate, mQuality);
+    int32 vocoderLatency = (mQuality == kQualityOffline) ? PhaseVocoderShifter<SampleType>::getLatency(mSampleRate) : 0;
+    int32 dryAlignLength = std::max(ReverseConvolver<SampleType>::getLatency(mSampleRate), vocoderLatency);
+    int32 wetAlignLength = vocoderLatency;
+
+    // Each channel gets its own oversampler, delay lines and reverb, sized for
+    // the sub-block and this sample rate
+    for (int i = 0; i < kMaxChannels; i++) {
+        mOversampler[i].layout(mArena, subBlockSize);
+        mDelayState[i].layout(mArena, mSampleRate);
+        mReverbState[i].layout(mArena, mSampleRate, dryAlignLength, wetAlignLength);
+    }
+
+    // The reverb's network and shimmer are shared by the channels; offline,
+    // the network is denser and the phase vocoder shifts in place of the grains
+    mFdn.layout(mArena, mSampleRate, mQuality == kQualityOffline);
+    mShimmer.layout(mArena, mSampleRate);
+    if (mQuality == kQualityOffline)
+        mVocoderShimmer.layout(mArena, mSampleRate);
+    mReverseReverb.layout(mArena, mSampleRate);
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::reset()
+{
+    // Reset all processing state (buffers keep their allocation)
+    for (int i = 0; i < kMaxChannels; i++)
+        mScratch[i].clear();
+
+    // The next block recomputes everything and jumps straight to its values
+    mRampsPrimed = false;
+    mDirtyGroups = kCoeffAll;
+
+    // Nothing is left ringing in the cleared lines
+    mTailRemaining = 0;
+    mQuietSamples = 0;
+
+    // Reset oversampling, delay and reverb state
+    for (int i = 0; i < kMaxChannels; i++) {
+        mOversampler[i].reset();
+        mDelayState[i].reset();
+        mReverbState[i].reset();
+    }
+    mFdn.reset();
+    mShimmer.reset();
+    mVocoderShimmer.reset();
+    mReverseReverb.reset();
+
+    // Reset the distortion's DC blockers and antialiasing history
+    mDistDcBlocker.reset();
+    for (int i = 0; i < kMaxChannels; i++)
+        mDistAdaaState[i].reset();
+
+    // Reset the modulation phase and state variables; every channel's LFO
+    // starts at the same phase, so the channels stay in step
+    for (int i = 0; i < kMaxChannels; i++) {
+        mModPhase[i] = 0.0f;
+        mModGateState[i] = 0.0f;
+        mFlangerFeedback[i] = 0.0f;
+        mPhaserStage1[i] = 0.0f;
+        mPhaserStage2[i] = 0.0f;
+        mPhaserStage3[i] = 0.0f;
+        mPhaserStage4[i] = 0.0f;
+        mPhaserFeedback[i] = 0.0f;
+    }
+
+    // The triode amp starts at its operating point
+    for (int i = 0; i < kMaxChannels; i++)
+        mTriode.reset(mTriodeState[i]);
+    mAmpLowpass.reset();
+    mToneStack.reset();
+    mPresence.reset();
+    mCabinet.reset();
+
+    // Reset NAM-inspired neural network state
+    for (int i = 0; i < 2; i++) {
+        mDynamicGain[i] = 1.0f;
+
+        for (int j = 0; j < kAmpTaps - 1; j++) {
+            mNeuralHistory[i][j] = 0.0f;
+        }
+
+        for (int j = 0; j < kAmpMemory; j++) {
+            mMemoryState[i][j] = 0.0f;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Stage graph
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+int32 EffectChain<SampleType>::buildStageList(Stage* stages, int32& oversampledBegin, int32& oversampledEnd) const
+{
+    // Every mode has its own compiled kernel; the mode picks it from these tables
+    static const StageProc kDistortionKernels[kNumDistAntialiasModes][kNumDistTypes] = {
+        {
+            &EffectChain::template processDistortionBlock<kDistClean, kDistAntialiasOff>,
+            &EffectChain::template processDistortionBlock<kDistCrunch, kDistAntialiasOff>,
+            &EffectChain::template processDistortionBlock<kDistFuzz, kDistAntialiasOff>,
+            &EffectChain::template processDistortionBlock<kDistAsymmetric, kDistAntialiasOff>,
+            &EffectChain::template processDistortionBlock<kDistOctaveFuzz, kDistAntialiasOff>
+        },
+        {
+            &EffectChain::template processDistortionBlock<kDistClean, kDistAntialiasAdaa1>,
+            &EffectChain::template processDistortionBlock<kDistCrunch, kDistAntialiasAdaa1>,
+            &EffectChain::template processDistortionBlock<kDistFuzz, kDistAntialiasAdaa1>,
+            &EffectChain::template processDistortionBlock<kDistAsymmetric, kDistAntialiasAdaa1>,
+            &EffectChain::template processDistortionBlock<kDistOctaveFuzz, kDistAntialiasAdaa1>
+        },
+        {
+            &EffectChain::template processDistortionBlock<kDistClean, kDistAntialiasAdaa2>,
+            &EffectChain::template processDistortionBlock<kDistCrunch, kDistAntialiasAdaa2>,
+            &EffectChain::template processDistortionBlock<kDistFuzz, kDistAntialiasAdaa2>,
+            &EffectChain::template processDistortionBlock<kDistAsymmetric, kDistAntialiasAdaa2>,
+            &EffectChain::template processDistortionBlock<kDistOctaveFuzz, kDistAntialiasAdaa2>
+        }
+    };
+    static const StageProc kModulationKernels[kNumQualityTiers][kNumModTypes] = {
+        {
+            &EffectChain::template processModulationBlock<kModChorus, kQualityRealtime>,
+            &EffectChain::template processModulationBlock<kModFlanger, kQualityRealtime>,
+            &EffectChain::template processModulationBlock<kModPhaser, kQualityRealtime>
+        },
+        {
+            &EffectChain::template processModulationBlock<kModChorus, kQualityOffline>,
+            &EffectChain::template processModulationBlock<kModFlanger, kQualityOffline>,
+            &EffectChain::template processModulationBlock<kModPhaser, kQualityOffline>
+        }
+    };
+    static const StageProc kDelayKernels[kNumQualityTiers][2] = {
+        {
+            &EffectChain::template processDelayBlock<false, kQualityRealtime>,
+            &EffectChain::template processDelayBlock<true, kQualityRealtime>
+        },
+        {
+            &EffectChain::template processDelayBlock<false, kQualityOffline>,
+            &EffectChain::template processDelayBlock<true, kQualityOffline>
+        }
+    };
+    static const LinkedStageProc kReverbKernels[kNumQualityTiers][2] = {
+        {
+            &EffectChain::template processReverbBlock<false, kQualityRealtime>,
+            &EffectChain::template processReverbBlock<true, kQualityRealtime>
+        },
+        {
+            &EffectChain::template processReverbBlock<false, kQualityOffline>,
+            &EffectChain::template processReverbBlock<true, kQualityOffline>
+        }
+    };
+
+    // Bypass and mode decisions are made here, once per block, instead of per sample
+    int32 numStages = 0;
+
+    // A captured amp runs at the host rate ahead of the oversampled range,
+    // and only while that is the rate it was trained at; the built-in network
+    // and the triode are oversampled
+    bool captured = (mParams.ampModel == kAmpModelCaptured && mAmpModel && mAmpModel->runsAtRate(mSampleRate));
+    if (mParams.ampBypass <= 0.5f && captured)
+        stages[numStages++] = {&EffectChain::processCapturedAmpBlock, "CapturedAmp"};
+
+    // The nonlinear stages come first and are the only ones worth oversampling
+    oversampledBegin = numStages;
+
+    if (mParams.ampBypass <= 0.5f && !captured) {
+        if (mParams.ampModel == kAmpModelTriode)
+            stages[numStages++] = {&EffectChain::processTriodeAmpBlock, "TriodeAmp"};
+        else {
+            stages[numStages++] = {&EffectChain::processAmpBlock, "Amp"};
+            stages[numStages++] = {"AmpLowpass", &EffectChain::processAmpLowpassBlock};
+        }
+    }
+
+    // Every amp engine feeds the tone stack, which runs at the oversampled
+    // rate as the distortion follows it
+    if (mParams.ampBypass <= 0.5f)
+        stages[numStages++] = {"ToneStack", &EffectChain::processToneStack};
+
+    if (mParams.distBypass <= 0.5f) {
+        int distType = std::max(0, std::min(mParams.distType, kNumDistTypes - 1));
+        int antialias = std::max(0, std::min(mParams.distAntialias, kNumDistAntialiasModes - 1));
+        stages[numStages++] = {kDistortionKernels[antialias][distType], "Distortion"};
+    }
+
+    oversampledEnd = numStages;
+
+    // The cabinet follows the built-in and triode amps at the host rate when
+    // it is switched on; a capture may well include its own
+    if (mParams.ampBypass <= 0.5f && !captured && mParams.cabinet > 0.5f)
+        stages[numStages++] = {"Cabinet", &EffectChain::processCabinetBlock};
+
+    // Skip modulation entirely if depth is too low
+    if (mParams.modBypass <= 0.5f && mParams.modDepth > 0.01f) {
+        int modType = std::max(0, std::min(mParams.modType, kNumModTypes - 1));
+        stages[numStages++] = {kModulationKernels[mQuality][modType], "Modulation"};
+    }
+
+    // Skip delay entirely if the delay is mixed out
+    if (mParams.delayBypass <= 0.5f && mParams.delayMix > 0.01f)
+        stages[numStages++] = {kDelayKernels[mQuality][mParams.delayReverse > 0.5f], "Delay"};
+
+    // Skip reverb entirely if the reverb is mixed out; the dry signal still
+    // runs through its alignment delay where the reverb adds latency
+    if (mParams.reverbBypass <= 0.5f && mParams.reverbMix > 0.01f)
+        stages[numStages++] = {"Reverb", kReverbKernels[mQuality][mParams.reverbReverse > 0.5f]};
+    else if (mReverbLatency > 0)
+        stages[numStages++] = {&EffectChain::processReverbAlignBlock, "ReverbAlign"};
+
+    return numStages;
+}
+
+//-----------------------------------------------------------------------------
+// Derived coefficients
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::updateCoefficients(uint32 groups)
+{
+    Coefficients& c = mCoeffs;
+
+    if (groups & kCoeffAmp)
+        c.ampGain = 1.0f + mParams.gain * 2.0f; // 1x to 3x
+
+    if (groups & kCoeffOversampling) {
+        for (int i = 0; i < kMaxChannels; i++)
+            mOversampler[i].setFactor(getEffectiveOversampling(mParams.oversampling, mQuality));
+
+        // The amp's gain follower keeps its host-rate time constant at any factor
+        c.ampGainFollow = (float)(1.0 - std::pow(1.0 - 0.01, 1.0 / mOversampler[0].getFactor()));
+
+        // 10 Hz corner for the distortion's DC blocker at the rate it runs at
+        mDistDcBlocker.setCoefficients(OnePoleCoefficients::highpass(mSampleRate * mOversampler[0].getFactor(), 10.0));
+
+        // The built-in amp's lowpass corner stays at 20 kHz (or just under
+        // Nyquist at 1x), so every factor and both tiers voice it alike
+        double ampRate = mSampleRate * mOversampler[0].getFactor();
+        mAmpLowpass.setCoefficients(BiquadCoefficients::lowpass(ampRate, std::min(20000.0, ampRate * 0.45), 0.7071));
+    }
+
+    // The tone stack runs at the oversampled rate too, so a new factor redesigns it
+    if (groups & (kCoeffToneStack | kCoeffOversampling)) {
+        double toneRate = mSampleRate * mOversampler[0].getFactor();
+        mToneStack.design(toneRate, mParams.bass, mParams.mid, mParams.treble);
+
+        // Presence shelves the top end from -6 to +6 dB, flat at its centre
+        mPresence.setCoefficients(BiquadCoefficients::highShelf(toneRate, 3000.0, 0.7071, (mParams.presence - 0.5) * 12.0));
+    }
+
+    if (groups & kCoeffDist) {
+        c.distDrive = 1.0f + mParams.distDrive * 4.0f; // 1x to 5x drive
+    }
+
+    if (groups & kCoeffMod) {
+        // More conservative modulation rate
+        float rate = 0.1f + mParams.modRate * 1.0f; // Further reduced max rate
+        c.modPhaseIncrement = rate / (float)mSampleRate;
+        c.msToSamples = (float)mSampleRate / 1000.0f;
+        c.modDepth = mParams.modDepth;
+    }
+
+    if (groups & kCoeffDelay) {
+        float delayTimeInSeconds = getDelaySeconds(mParams.delayTime);
+        int delayLength = mDelayState[0].delayBuffer.size();
+
+        // Make sure delay time doesn't exceed buffer size
+        c.delaySamples = std::min((int)(delayTimeInSeconds * mSampleRate), delayLength - 1);
+        c.delayFraction = (c.delaySamples < delayLength - 1) ? (float)(delayTimeInSeconds * mSampleRate - c.delaySamples) : 0.0f;
+        c.reverseSegmentLength = (int)(delayTimeInSeconds * mSampleRate);
+        c.delayMix = mParams.delayMix;
+        c.delayFeedback = mParams.delayFeedback;
+    }
+
+    if (groups & kCoeffReverb) {
+        // Reverb dry/wet with gain compensation to maintain perceived loudness
+        float wetLevel = mParams.reverbMix;
+        float dryLevel = 1.0f - mParams.reverbMix;
+        float totalGain = std::sqrt(dryLevel * dryLevel + wetLevel * wetLevel);
+        if (totalGain > 0.0f) {
+            dryLevel /= totalGain;
+            wetLevel /= totalGain;
+        }
+        c.reverbMix = mParams.reverbMix;
+        c.reverbDry = dryLevel;
+        c.reverbWet = wetLevel;
+
+        float size = mParams.reverbSize;
+        c.reverbPreDelay = (float)(mSampleRate * getReverbPreDelaySeconds(size));
+        c.reverbGlide = (float)(1.0 - std::exp(-1.0 / (FdnReverb<SampleType>::kGlideSeconds * mSampleRate)));
+        c.reverbDecay = getReverbDecaySeconds(size);
+        c.shimmer = mParams.reverbShimmer > kMinShimmer;
+        c.shimmerAmount = mParams.reverbShimmer * 0.6f;                      // Reduced intensity
+        c.shimmerFeedback = getShimmerFeedback(mParams.reverbShimmer);
+
+        // The lines grow 1x to 4x with the size (their taps glide there with
+        // the pre-delay's), and the highs die away faster, more so and from
+        // lower down in small rooms
+        mFdn.setSize(getReverbSizeMultiplier(size));
+        mFdn.setDecay(c.reverbDecay, c.reverbDecay * (0.3 + size * 0.3), 1150.0 + (1.0f - size) * 1850.0);
+
+        // The reverse swell lasts 0.5 to 3 seconds, and its convolution adds
+        // a block of latency while it is selected; offline, the vocoder's
+        // frame does otherwise
+        mReverseReverb.setLength(getReverseSwellSeconds(size));
+        mReverbLatency = getReverbLatency(mParams, mSampleRate, mQuality);
+    }
+
+    if (groups & kCoeffOutput)
+        c.outputLevel = mParams.outputLevel;
+
+    if (groups & (kCoeffDelay | kCoeffReverb | kCoeffOversampling))
+        updateTailLength();
+}
+
+//-----------------------------------------------------------------------------
+// Tail tracking
+//-----------------------------------------------------------------------------
+namespace {
+
+// Samples until a loop repeating every period samples with the given gain per
+// pass decays below the tail threshold
+uint64 feedbackDecaySamples(float feedback, int32 period)
+{
+    feedback = std::fabs(feedback);
+    if (feedback <= EffectChainBase::kTailThreshold)
+        return (uint64)period;
+    if (feedback >= 1.0f)
+        return Vst::kInfiniteTail;
+
+    double passes = std::ceil(std::log((double)EffectChainBase::kTailThreshold) / std::log((double)feedback));
+    return (uint64)period * (uint64)(passes + 1.0);
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+uint32 EffectChain<SampleType>::computeTailSamples(const ChainParameters& params, int32& gap) const
+{
+    // Active stages match buildStageList(); the amp, distortion and modulation
+    // only hold a few samples of filter state and add no audible tail
+    bool delayActive = params.delayBypass <= 0.5f && params.delayMix > 0.01f;
+    bool reverbActive = params.reverbBypass <= 0.5f && params.reverbMix > 0.01f;
+
+    // Everything comes out later by the oversampling and reverb latency
+    int32 latency = getLatency(params, mSampleRate, mQuality);
+    uint64 tail = (uint64)latency;
+    gap = latency;
+
+    if (delayActive) {
+        // The echo as updateCoefficients() clamps it to the line
+        int32 echo = (int32)(getDelaySeconds(params.delayTime) * mSampleRate);
+        int32 period;
+        if (params.delayReverse > 0.5f) {
+            // A reversed segment comes back one to two segment lengths later
+            const ReverseDelay<SampleType>& reverse = mDelayState[0].reverse;
+            int32 segment = std::max(1, std::min(echo, reverse.getMaxSegmentLength()));
+            period = 2 * segment + (int32)(mSampleRate * ReverseDelay<SampleType>::kCrossfadeSeconds);
+        } else {
+            period = std::max(1, std::min(echo, (int32)mDelayState[0].delayBuffer.size() - 1));
+        }
+
+        tail += feedbackDecaySamples(params.delayFeedback, period);
+        gap += period;
+    }
+
+    if (reverbActive && params.reverbReverse > 0.5f) {
+        // The reverse swell ends dead at the end of its impulse, and may
+        // stay below the threshold for most of its rise
+        int32 swell = mReverseReverb.getLength(getReverseSwellSeconds(params.reverbSize));
+        tail += (uint64)swell;
+        gap += swell;
+    } else if (reverbActive) {
+        const ReverbChannelState<SampleType>& state = mReverbState[0];
+        const float size = params.reverbSize;
+
+        // The network falls 60 dB over its decay time, whatever the line
+        // lengths; the longest line is the longest gap between echoes
+        int32 longestLine = mFdn.getLongestLine(getReverbSizeMultiplier(size));
+        double decayDb = -20.0 * std::log10((double)kTailThreshold);
+        uint64 decay = (uint64)(getReverbDecaySeconds(size) * mSampleRate * decayDb / 60.0);
+
+        // Fed back, the shimmer stretches the decay, by about 1.7x at full
+        // feedback and size
+        bool shimmer = params.reverbShimmer > kMinShimmer;
+        if (shimmer)
+            decay = (uint64)(decay * (1.0 + getShimmerFeedback(params.reverbShimmer)));
+
+        int32 lead = (int32)std::ceil((float)(mSampleRate * getReverbPreDelaySeconds(size))) +
+                     state.allpass1.size() + state.allpass2.size();
+        if (shimmer)
+            lead += (mQuality == kQualityOffline) ? PhaseVocoderShifter<SampleType>::getLatency(mSampleRate)
+                                                  : mShimmer.getGrainLength();
+
+        tail += (uint64)lead + longestLine + decay;
+        gap += lead + longestLine;
+    }
+
+    return (tail >= Vst::kInfiniteTail) ? Vst::kInfiniteTail : (uint32)tail;
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::updateTailLength()
+{
+    mTailSamples = computeTailSamples(mParams, mTailGap);
+
+    // A running tail follows the new settings
+    if (mTailRemaining > 0)
+        mTailRemaining = mTailSamples;
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::updateTailState(SampleType inputPeak, SampleType outputPeak, int32 numSamples)
+{
+    if (inputPeak > 0.0f) {
+        // New input restarts the tail
+        mTailRemaining = std::max<uint32>(mTailSamples, 1);
+    } else if (mTailRemaining != Vst::kInfiniteTail) {
+        mTailRemaining -= std::min<uint32>(mTailRemaining, (uint32)numSamples);
+    }
+
+    // Quiet output only ends the tail once no echo can still be on its way
+    if (outputPeak < kTailThreshold) {
+        mQuietSamples = std::min(mQuietSamples + numSamples, mTailGap + numSamples);
+        if (inputPeak == 0.0f && mQuietSamples > mTailGap)
+            mTailRemaining = 0;
+    } else {
+        mQuietSamples = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::updateRampTargets(int32 numSamples)
+{
+    // Derived gains and mixes are ramped; the stages only read the ramp blocks
+    SampleType targets[kNumRamps];
+    targets[kRampAmpGain] = mCoeffs.ampGain;
+    targets[kRampDistDrive] = mCoeffs.distDrive;
+    targets[kRampModDepth] = mCoeffs.modDepth;
+    targets[kRampDelayMix] = mCoeffs.delayMix;
+    targets[kRampDelayFeedback] = mCoeffs.delayFeedback;
+    targets[kRampReverbMix] = mCoeffs.reverbMix;
+    targets[kRampReverbDry] = mCoeffs.reverbDry;
+    targets[kRampReverbWet] = mCoeffs.reverbWet;
+    targets[kRampOutputLevel] = mCoeffs.outputLevel;
+
+    // New values ramp in across this call, so automation slices are followed
+    // exactly, but never faster than one sub-block so steps cannot click.
+    // After a reset the values are taken over directly instead of ramping from stale ones.
+    int32 rampLength = std::max(numSamples, kSubBlockSize);
+    for (int i = 0; i < kNumRamps; i++) {
+        if (mRampsPrimed)
+            mRampParams[i].setTarget(targets[i], rampLength);
+        else
+            mRampParams[i].setValue(targets[i]);
+    }
+    mRampsPrimed = true;
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::fillRampBlocks(int32 numSamples)
+{
+    for (int i = 0; i < kNumRamps; i++)
+        mRampBlocks[i] = mRampParams[i].getBlock(numSamples);
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::process(const ChainParameters& params, SampleType** inputs, SampleType** outputs,
+                          int32 numChannels, int32 numSamples)
+{
+    mParams = params;
+    numChannels = std::min(numChannels, kMaxChannels);
+
+    // Without buffers (allocation failed in prepare) the chain passes audio through
+    if (!mPrepared) {
+        for (int32 channel = 0; channel < numChannels; channel++) {
+            if (outputs[channel] != inputs[channel])
+                std::copy(inputs[channel], inputs[channel] + numSamples, outputs[channel]);
+        }
+        return;
+    }
+
+    // Coefficients are only recomputed for the groups a parameter change marked dirty
+    if (mDirtyGroups != 0) {
+        updateCoefficients(mDirtyGroups);
+        updateRampTargets(numSamples);
+        mDirtyGroups = 0;
+    }
+
+    Stage stages[kMaxStages];
+    int32 oversampledBegin = 0;
+    int32 oversampledEnd = 0;
+    int32 numStages = buildStageList(stages, oversampledBegin, oversampledEnd);
+
+    // Without any oversampled stage the signal is only delayed, so the latency never changes
+    bool oversampled = (oversampledEnd > oversampledBegin);
+
+    int32 subBlockSize = mScratch[0].size();
+
+    // Peaks over the whole call drive the tail tracking
+    SampleType blockInputPeak = 0.0f;
+    SampleType blockOutputPeak = 0.0f;
+
+    // Run the whole chain on one sub-block at a time so the scratch buffers stay in cache
+    for (int32 offset = 0; offset < numSamples; offset += subBlockSize)
+    {
+        int32 blockSize = std::min(subBlockSize, numSamples - offset);
+
+        // Both channels of a sub-block share the same parameter ramps
+        fillRampBlocks(blockSize);
+
+        SampleType* buffers[kMaxChannels];
+        for (int32 channel = 0; channel < numChannels; channel++)
+        {
+            const SampleType* ptrIn = inputs[channel] + offset;
+            SampleType* buffer = mScratch[channel].data;
+            buffers[channel] = buffer;
+
+            SampleType inputPeak = 0.0f;
+            for (int32 i = 0; i < blockSize; i++) {
+                buffer[i] = ptrIn[i];
+                inputPeak = std::max(inputPeak, std::fabs(buffer[i]));
+            }
+
+            blockInputPeak = std::max(blockInputPeak, inputPeak);
+
+            // Log input level and detect clipping
+            if (inputPeak > 0.95f) {
+                VST_LOG_CLIPPING("Input", inputPeak, 0.95f);
+            }
+        }
+
+        // Every stage runs on all channels before the next one starts
+        int32 s = 0;
+        for (; s < oversampledBegin; s++)
+            runStage(stages[s], buffers, numChannels, blockSize);
+
+        if (oversampled) {
+            SampleType* upsampled[kMaxChannels];
+            for (int32 channel = 0; channel < numChannels; channel++)
+                upsampled[channel] = mOversampler[channel].upsample(buffers[channel], blockSize);
+
+            mRampShift = mOversampler[0].getFactorLog2();
+            for (; s < oversampledEnd; s++)
+                runStage(stages[s], upsampled, numChannels, blockSize << mRampShift);
+            mRampShift = 0;
+
+            for (int32 channel = 0; channel < numChannels; channel++)
+                mOversampler[channel].downsample(buffers[channel], blockSize);
+        } else {
+            for (int32 channel = 0; channel < numChannels; channel++)
+                mOversampler[channel].delay(buffers[channel], blockSize);
+        }
+
+        for (; s < numStages; s++)
+            runStage(stages[s], buffers, numChannels, blockSize);
+
+        for (int32 channel = 0; channel < numChannels; channel++)
+        {
+            SampleType* ptrOut = outputs[channel] + offset;
+            const SampleType* buffer = buffers[channel];
+
+            // Apply output level (always applied, even when amp is bypassed)
+            const SampleType* outputLevel = mRampBlocks[kRampOutputLevel];
+            SampleType outputPeak = 0.0f;
+            for (int32 i = 0; i < blockSize; i++) {
+                SampleType processed = buffer[i] * outputLevel[i];
+                outputPeak = std::max(outputPeak, std::fabs(processed));
+                ptrOut[i] = processed;
+            }
+
+            blockOutputPeak = std::max(blockOutputPeak, outputPeak);
+
+            // Final clipping check
+            if (outputPeak > 0.98f) {
+                VST_LOG_CLIPPING("FinalOutput", outputPeak, 0.98f);
+            }
+        }
+    }
+
+    updateTailState(blockInputPeak, blockOutputPeak, numSamples);
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::runStage(const Stage& stage, SampleType* const* buffers, int32 numChannels,
+                                       int32 numSamples)
+{
+    static const char* const kChannelNames[kMaxChannels] = {"channel_0", "channel_1"};
+
+    SampleType preStage[kMaxChannels];
+    for (int32 channel = 0; channel < numChannels; channel++)
+        preStage[channel] = buffers[channel][0];
+
+    if (stage.linkedProc) {
+        (this->*stage.linkedProc)(buffers, numChannels, numSamples);
+    } else {
+        for (int32 channel = 0; channel < numChannels; channel++)
+            (this->*stage.proc)(buffers[channel], numSamples, channel);
+    }
+
+    for (int32 channel = 0; channel < numChannels; channel++) {
+        const SampleType* buffer = buffers[channel];
+        VST_LOG_AUDIO(stage.name, preStage[channel], buffer[0], kChannelNames[channel]);
+
+        SampleType stagePeak = 0.0f;
+        for (int32 i = 0; i < numSamples; i++)
+            stagePeak = std::max(stagePeak, std::fabs(buffer[i]));
+
+        if (stagePeak > 0.95f) {
+            VST_LOG_CLIPPING(stage.name, stagePeak, 0.95f);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Amp simulation and EQ processing
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processAmpBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    // NAM-inspired neural amp modeling approach, evaluated over the whole
+    // block: the feed-forward layers run as products across time and only the
+    // recurrent parts step sample by sample
+    const SampleType* baseGain = mRampBlocks[kRampAmpGain]; // Base gain from user control
+    const int shift = mRampShift;
+    const SampleType gainFollow = mCoeffs.ampGainFollow;
+
+    // ===== STAGE 1: INPUT HISTORY COLLECTION =====
+    // The block goes right after the last inputs (like NAM's temporal modeling),
+    // so each tap of the input convolution reads one contiguous run
+    SampleType* history = mAmpInput.data;
+    std::copy(mNeuralHistory[channel], mNeuralHistory[channel] + kAmpTaps - 1, history);
+    std::copy(buffer, buffer + numSamples, history + kAmpTaps - 1);
+    const SampleType* input = history + kAmpTaps - 1;
+
+    // ===== STAGE 2: DYNAMIC GAIN ADAPTATION =====
+    // Simulate amp's dynamic response to input level (like NAM's level-dependent modeling)
+    SampleType* drive = mAmpDrive.data;
+    SampleType dynamicGain = mDynamicGain[channel];
+    for (int32 n = 0; n < numSamples; n++) {
+        SampleType inputLevel = fabs(input[n]);
+        SampleType targetGain = baseGain[n >> shift];
+
+        // Dynamic gain adjustment based on input level (amp compression/expansion)
+        if (inputLevel > 0.1f) {
+            targetGain *= (1.0f - (inputLevel - 0.1f) * 0.3f); // Compression at high levels
+        } else {
+            targetGain *= (1.0f + (0.1f - inputLevel) * 0.2f); // Slight expansion at low levels
+        }
+
+        // Smooth gain changes to avoid artifacts
+        dynamicGain += (targetGain - dynamicGain) * gainFollow;
+        drive[n] = dynamicGain;
+    }
+    mDynamicGain[channel] = dynamicGain;
+
+    // ===== STAGE 3: NEURAL NETWORK PROCESSING =====
+    // Simplified 3-layer neural network inspired by NAM architecture
+
+    // Layer 1: Input processing with history, one pass over the block per tap
+    // (oldest first)
+    SampleType* layer1 = mAmpLayer1.data;
+    std::fill(layer1, layer1 + numSamples, mNeuralBias[0]);
+    for (int i = 0; i < kAmpTaps; i++) {
+        const SampleType* tap = history + i;
+        const SampleType weight = mNeuralWeights[0][i];
+        for (int32 n = 0; n < numSamples; n++)
+            layer1[n] += tap[n] * weight;
+    }
+    for (int32 n = 0; n < numSamples; n++)
+        layer1[n] = fastTanh(layer1[n]); // Activation function
+
+    // Layer 2 input and its harmonic content don't depend on the memory
+    SampleType* harmonic = mAmpHarmonic.data;
+    for (int32 n = 0; n < numSamples; n++) {
+        drive[n] *= layer1[n];
+        harmonic[n] = fastSin(drive[n] * 3.14159f) * mNeuralWeights[1][6] * 0.1f;
+    }
+
+    // Layer 2: Nonlinear processing (main amp character). Its own last
+    // outputs feed back, so this is the one loop that runs sample by sample;
+    // layer2[n - k - 1] is what the memory state held k steps back
+    SampleType* layer2 = mAmpLayer2.data + kAmpMemory;
+    for (int k = 0; k < kAmpMemory; k++)
+        layer2[-k - 1] = mMemoryState[channel][k];
+
+    for (int32 n = 0; n < numSamples; n++) {
+        const SampleType layer2_input = drive[n];
+        SampleType layer2_sum = mNeuralBias[1];
+
+        // Use current and previous activations for temporal modeling
+        layer2_sum += layer2_input * mNeuralWeights[1][0];
+        layer2_sum += layer2[n - 1] * mNeuralWeights[1][1]; // Memory feedback
+        layer2_sum += layer2[n - 2] * mNeuralWeights[1][2];
+        layer2_sum += layer2[n - 3] * mNeuralWeights[1][3];
+        layer2_sum += layer2_input * layer2_input * mNeuralWeights[1][4]; // Nonlinear term
+        layer2_sum += layer2_input * layer2[n - 1] * mNeuralWeights[1][5]; // Cross term
+        layer2_sum += harmonic[n]; // Harmonic content
+        layer2_sum += layer2_input * fabs(layer2_input) * mNeuralWeights[1][7] * 0.5f; // Asymmetric term
+
+        layer2[n] = fastTanh(layer2_sum * 0.8f); // Prevent saturation
+    }
+
+    // Layer 3: Output shaping and filtering
+    for (int32 n = 0; n < numSamples; n++) {
+        SampleType layer3_sum = mNeuralBias[2];
+        layer3_sum += layer2[n] * mNeuralWeights[2][0];
+        layer3_sum += layer1[n] * mNeuralWeights[2][1]; // Skip connection
+        layer3_sum += layer2[n - kAmpMemory] * mNeuralWeights[2][2]; // Long-term memory
+        layer3_sum += input[n] * mNeuralWeights[2][3] * 0.1f; // Dry signal blend
+
+        SampleType neuralOutput = fastTanh(layer3_sum);
+
+        // ===== STAGE 5: FINAL PROCESSING =====
+        // Conservative output scaling (the tone stack follows)
+        buffer[n] = neuralOutput * 0.8f;
+    }
+
+    // ===== STAGE 4: MEMORY STATE UPDATE =====
+    // Keep the last inputs and outputs for the next block (amp's temporal behavior)
+    std::copy(history + numSamples, history + numSamples + kAmpTaps - 1, mNeuralHistory[channel]);
+    for (int k = 0; k < kAmpMemory; k++)
+        mMemoryState[channel][k] = layer2[numSamples - k - 1];
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processCapturedAmpBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    // The gain knob trims the capture's input around unity (at its centre),
+    // the tone stack follows it the way it follows the built-in network
+    const SampleType* baseGain = mRampBlocks[kRampAmpGain];
+    float* model = mModelScratch.data;
+
+    for (int32 n = 0; n < numSamples; n++)
+        model[n] = (float)(buffer[n] * baseGain[n] * (SampleType)0.5);
+
+    mAmpModel->process(channel, model, numSamples);
+
+    for (int32 n = 0; n < numSamples; n++)
+        buffer[n] = (SampleType)model[n];
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processTriodeAmpBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    // The gain knob sets the grid swing: a full-scale signal drives the grid
+    // from cutoff into conduction at the top of the knob. The load sees up to
+    // a hundred volts or so, scaled back down to the other engines' level
+    // ahead of the same tone stack
+    const SampleType* baseGain = mRampBlocks[kRampAmpGain];
+    const int shift = mRampShift;
+
+    for (int32 n = 0; n < numSamples; n++)
+        buffer[n] *= baseGain[n >> shift] * kTriodeGridVolts;
+
+    mTriode.process(buffer, numSamples, shift, mTriodeState[channel]);
+
+    for (int32 n = 0; n < numSamples; n++)
+        buffer[n] *= kTriodeOutputScale * (SampleType)0.8f;
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processAmpLowpassBlock(SampleType* const* buffers, int32 numChannels, int32 numSamples)
+{
+    // One SIMD lane per channel, as in the tone stack
+    if (numChannels >= 2)
+        mAmpLowpass.template process<2>(buffers, numSamples);
+    else
+        mAmpLowpass.template process<1>(buffers, numSamples);
+}
+
+//-----------------------------------------------------------------------------
+// Tone stack
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processToneStack(SampleType* const* buffers, int32 numChannels, int32 numSamples)
+{
+    // One SIMD lane per channel; a mono input leaves the second lane idle.
+    // The presence shelf follows the stack, the way the control sits after
+    // the tone controls on the amp
+    if (numChannels >= 2) {
+        mToneStack.template process<2>(buffers, numSamples);
+        mPresence.template process<2>(buffers, numSamples);
+    } else {
+        mToneStack.template process<1>(buffers, numSamples);
+        mPresence.template process<1>(buffers, numSamples);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Cabinet and Speaker Simulation
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::designCabinet()
+{
+    // Simulate a 4x12 guitar cabinet with Celestion-style speakers
+
+    // ===== CABINET RESONANCE =====
+    // Guitar cabinets have resonant frequencies that color the sound: a subtle low-end thump
+    mCabinet[0].setCoefficients(BiquadCoefficients::peak(mSampleRate, 100.0, 1.2, 1.5));
+
+    // ===== SPEAKER FREQUENCY RESPONSE =====
+    // Low-frequency rolloff (speakers don't reproduce very low frequencies well)
+    mCabinet[1].setCoefficients(BiquadCoefficients::highpass(mSampleRate, 80.0, 0.7071));
+
+    // Mid-frequency presence (speakers have a presence peak around 2-4kHz)
+    mCabinet[2].setCoefficients(BiquadCoefficients::peak(mSampleRate, 2500.0, 0.9, 1.6));
+
+    // High-frequency rolloff (speakers naturally roll off high frequencies)
+    mCabinet[3].setCoefficients(BiquadCoefficients::lowpass(mSampleRate, 5000.0, 0.7071));
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processCabinetBlock(SampleType* const* buffers, int32 numChannels, int32 numSamples)
+{
+    // The speaker's response, one SIMD lane per channel
+    if (numChannels >= 2)
+        mCabinet.template process<2>(buffers, numSamples);
+    else
+        mCabinet.template process<1>(buffers, numSamples);
+
+    for (int32 channel = 0; channel < numChannels; channel++) {
+        SampleType* buffer = buffers[channel];
+        for (int32 n = 0; n < numSamples; n++) {
+            // ===== SPEAKER SATURATION =====
+            // Speakers add subtle compression and harmonic distortion at high levels
+            SampleType speakerLevel = fabs(buffer[n]);
+            SampleType speakerSaturation = 1.0f / (1.0f + speakerLevel * 0.5f); // Gentle compression
+            SampleType speakerOutput = buffer[n] * speakerSaturation;
+
+            // Add subtle speaker cone resonance (very subtle harmonic content)
+            SampleType coneResonance = fastSin(speakerOutput * 2.5f) * 0.008f * speakerLevel;
+            speakerOutput += coneResonance;
+
+            // ===== CABINET AIR MOVEMENT =====
+            // Simulate the air movement and room acoustics of a guitar cabinet
+            SampleType airMovement = fastTanh(speakerOutput * 0.9f) * 1.05f; // Subtle air compression
+
+            buffer[n] = airMovement * 0.85f; // Conservative output level
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Distortion processing
+//-----------------------------------------------------------------------------
+namespace {
+
+// Curve shape of each distortion type, over the input times the drive, with
+// the type's level and the conservative 0.7 output scale applied. The shapes
+// are only evaluated at compile time, to fill the waveshaper tables; kBlocksDc
+// marks the uneven ones, whose output needs its offset taken out
+template <int DistType> struct DistortionCurve;
+
+template <> struct DistortionCurve<kDistClean>
+{
+    // Clean: just gentle tanh saturation
+    static constexpr bool kBlocksDc = false;
+    static constexpr double shape(double x) { return WaveshaperDetail::tanh(x * 0.8) * 0.7; }
+};
+
+template <> struct DistortionCurve<kDistCrunch>
+{
+    // Crunch: moderate tanh saturation
+    static constexpr bool kBlocksDc = false;
+    static constexpr double shape(double x) { return WaveshaperDetail::tanh(x * 1.2) * 0.9 * 0.7; }
+};
+
+template <> struct DistortionCurve<kDistFuzz>
+{
+    // Fuzz: harder tanh saturation
+    static constexpr bool kBlocksDc = false;
+    static constexpr double shape(double x) { return WaveshaperDetail::tanh(x * 1.8) * 0.8 * 0.7; }
+};
+
+template <> struct DistortionCurve<kDistAsymmetric>
+{
+    // Asymmetric: biased tanh that clips the negative half earlier and harder,
+    // like a tube grid drawing current; the uneven halves add even harmonics.
+    // Scaled so the negative half peaks at the crunch level
+    static constexpr bool kBlocksDc = true;
+    static constexpr double shape(double x)
+    {
+        const double bias = 0.4;
+        const double offset = WaveshaperDetail::tanh(bias);
+        return (WaveshaperDetail::tanh(x * 1.4 + bias) - offset) / (1.0 + offset) * 0.9 * 0.7;
+    }
+};
+
+template <> struct DistortionCurve<kDistOctaveFuzz>
+{
+    // Octave fuzz: a smooth full-wave rectifier (x tanh(4x) is |x| rounded
+    // off through zero) ahead of hard tanh saturation. Folding the negative
+    // half up doubles the dominant frequency, the octave-up of rectifier
+    // fuzzes; a quarter of the unfolded signal keeps some fundamental
+    static constexpr bool kBlocksDc = true;
+    static constexpr double shape(double x)
+    {
+        const double rectified = x * WaveshaperDetail::tanh(x * 4.0);
+        return WaveshaperDetail::tanh((rectified * 0.75 + x * 0.25) * 1.8) * 0.7;
+    }
+};
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <int DistType, int Antialias>
+void EffectChain<SampleType>::processDistortionBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    // Simple, clean distortion without noise gates or complex processing
+    typedef DistortionCurve<DistType> Curve;
+
+    // Simple drive control
+    const SampleType* drive = mRampBlocks[kRampDistDrive]; // 1x to 5x drive
+    const int shift = mRampShift;
+
+    for (int32 n = 0; n < numSamples; n++)
+        buffer[n] *= drive[n >> shift];
+
+    // The curve shape and output level are baked into the table (the curves
+    // never exceed 1.0, so the old output limiter is folded into the level).
+    // A loop of its own, as the shifted ramp reads would keep it from vectorizing.
+    // Antialiasing shapes from the curve's antiderivatives instead, which keeps
+    // hard curves clean without oversampling for about twice the cost
+    if constexpr (Antialias == kDistAntialiasAdaa1) {
+        WaveshaperTable<Curve>::processAdaa1(buffer, numSamples, mDistAdaaState[channel]);
+    } else if constexpr (Antialias == kDistAntialiasAdaa2) {
+        WaveshaperTable<Curve>::processAdaa2(buffer, numSamples, mDistAdaaState[channel]);
+    } else {
+        for (int32 n = 0; n < numSamples; n++)
+            buffer[n] = WaveshaperTable<Curve>::process(buffer[n]);
+    }
+
+    if constexpr (Curve::kBlocksDc) {
+        // The offset of the uneven curves follows the playing dynamics; a
+        // one-pole highpass well below the guitar's range takes it out
+        mDistDcBlocker.processLane(channel, buffer, numSamples);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Reverb processing
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <bool Reverse, int Quality>
+void EffectChain<SampleType>::processReverbBlock(SampleType* const* buffers, int32 numChannels, int32 numSamples)
+{
+    // The channels share one stereo network, so they run frame by frame
+    SampleType frame[kMaxChannels];
+
+    // The reverse reverb convolves the mono sum with its swelling stereo
+    // impulse, and adds the swell on top of the dry signal
+    if constexpr (Reverse) {
+        const SampleType* reverbMix = mRampBlocks[kRampReverbMix];
+        const SampleType inputScale = (SampleType)1 / (SampleType)numChannels;
+
+        for (int32 n = 0; n < numSamples; n++)
+        {
+            SampleType input = 0.0f;
+            for (int32 channel = 0; channel < numChannels; channel++)
+                input += buffers[channel][n];
+
+            SampleType swell[2];
+            mReverseReverb.process(input * inputScale, swell);
+
+            for (int32 channel = 0; channel < numChannels; channel++) {
+                SampleType dry = mReverbState[channel].alignDry(buffers[channel][n], mReverbLatency);
+                buffers[channel][n] = dry + swell[channel] * reverbMix[n];
+            }
+        }
+        return;
+    }
+
+    // Mix dry and wet signals with proper balance (gain compensated in updateRampTargets)
+    const SampleType* dryLevel = mRampBlocks[kRampReverbDry];
+    const SampleType* wetLevel = mRampBlocks[kRampReverbWet];
+
+    for (int32 n = 0; n < numSamples; n++)
+    {
+        for (int32 channel = 0; channel < numChannels; channel++)
+            frame[channel] = buffers[channel][n];
+
+        // Process with the feedback delay network reverb
+        processComplexReverbFrame<Quality>(frame, numChannels);
+
+        for (int32 channel = 0; channel < numChannels; channel++) {
+            SampleType dry = buffers[channel][n];
+            if constexpr (Quality == kQualityOffline)
+                dry = mReverbState[channel].alignDry(dry, mReverbLatency);
+
+            buffers[channel][n] = dry * dryLevel[n] + frame[channel] * wetLevel[n];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+void EffectChain<SampleType>::processReverbAlignBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    ReverbChannelState<SampleType>& state = mReverbState[channel];
+    for (int32 n = 0; n < numSamples; n++)
+        buffer[n] = state.alignDry(buffer[n], mReverbLatency);
+}
+
+//-----------------------------------------------------------------------------
+// Delay processing
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <bool Reverse, int Quality>
+void EffectChain<SampleType>::processDelayBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    const SampleType* delayMix = mRampBlocks[kRampDelayMix];
+    const SampleType* delayFeedback = mRampBlocks[kRampDelayFeedback];
+
+    DelayChannelState<SampleType>& state = mDelayState[channel];
+    ArenaBuffer<SampleType>& delayBuffer = state.delayBuffer;
+    int delayLength = delayBuffer.size();
+
+    // Handle reverse delay if enabled
+    if constexpr (Reverse) {
+        // Each delay time worth of input is played back reversed
+        int segmentLength = mCoeffs.reverseSegmentLength;
+
+        for (int32 n = 0; n < numSamples; n++)
+        {
+            SampleType input = buffer[n];
+
+            // Reversed repeats feed back into the capture, so they re-reverse on each pass
+            SampleType reversed = state.reverse.processSample(input, delayFeedback[n], segmentLength);
+
+            // The echo line carries the reversed repeats for the modulation taps
+            delayBuffer[state.delayPos] = reversed * delayFeedback[n];
+            state.delayPos = (state.delayPos + 1) % delayLength;
+
+            // Use a higher mix ratio for the reverse delay to make it more noticeable
+            SampleType wetMix = std::min<SampleType>(delayMix[n] * 1.5f, 1);
+            buffer[n] = input * (1.0f - wetMix) + reversed * wetMix;
+        }
+        return;
+    }
+
+    // Delay time in samples, already clamped to the buffer size
+    int delaySamples = mCoeffs.delaySamples;
+
+    // Offline renders hit the exact delay time between samples
+    SampleType delayFraction = mCoeffs.delayFraction;
+
+    for (int32 n = 0; n < numSamples; n++)
+    {
+        SampleType input = buffer[n];
+
+        // Get current position
+        int readPos = state.delayPos - delaySamples;
+        if (readPos < 0) {
+            readPos += delayLength;
+        }
+
+        // Read from delay buffer
+        SampleType delayedSample;
+        if constexpr (Quality == kQualityOffline) {
+            int olderPos = (readPos == 0) ? delayLength - 1 : readPos - 1;
+            delayedSample = readCubic(delayBuffer.data, delayLength, olderPos, (SampleType)1 - delayFraction);
+        } else {
+            delayedSample = delayBuffer[readPos];
+        }
+
+        // Write to delay buffer with feedback
+        delayBuffer[state.delayPos] = input + delayedSample * delayFeedback[n];
+
+        // Update position
+        state.delayPos = (state.delayPos + 1) % delayLength;
+
+        // Mix dry and wet signals
+        buffer[n] = input * (1.0f - delayMix[n]) + delayedSample * delayMix[n];
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Modulation processing (chorus/flanger/phaser)
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <int ModType, int Quality>
+void EffectChain<SampleType>::processModulationBlock(SampleType* buffer, int32 numSamples, int channel)
+{
+    SampleType phaseIncrement = mCoeffs.modPhaseIncrement;
+    const SampleType* depth = mRampBlocks[kRampModDepth];
+
+    // Delay-line conversions are resolved when the rate or sample rate changes
+    SampleType msToSamples = mCoeffs.msToSamples;
+
+    // Chorus and flanger tap this channel's echo line
+    const DelayChannelState<SampleType>& delay = mDelayState[channel];
+    const SampleType* delayBuffer = delay.delayBuffer.data;
+    int delayLength = delay.delayBuffer.size();
+
+    // This channel's LFO, gate and filter state
+    SampleType& modPhase = mModPhase[channel];
+    SampleType& gateState = mModGateState[channel];
+    SampleType& flangerFeedback = mFlangerFeedback[channel];
+    SampleType& phaserStage1 = mPhaserStage1[channel];
+    SampleType& phaserStage2 = mPhaserStage2[channel];
+    SampleType& phaserStage3 = mPhaserStage3[channel];
+    SampleType& phaserStage4 = mPhaserStage4[channel];
+    SampleType& phaserFeedback = mPhaserFeedback[channel];
+
+    for (int32 n = 0; n < numSamples; n++)
+    {
+        SampleType input = buffer[n];
+
+        // Update phase smoothly; the LFO runs through gated samples too, so
+        // the channels' phases never drift apart
+        modPhase += phaseIncrement;
+        if (modPhase >= 1.0f) {
+            modPhase -= 1.0f;
+        }
+
+        // Apply noise gate with hysteresis - using member variables
+        if (fabs(input) < 0.0003f && gateState == 0.0f) {
+            continue;
+        } else if (fabs(input) > 0.0005f) {
+            gateState = 1.0f;
+        } else if (fabs(input) < 0.0003f) {
+            gateState = 0.0f;
+            continue;
+        }
+
+        // Calculate LFO value with better waveform
+        SampleType lfo = 0.5f + 0.5f * fastSin(TWO_PI * modPhase);
+
+        // Depth comes from its ramp, so no extra smoothing is needed against zipper noise
+        SampleType modDepth = depth[n];
+
+        // Apply different modulation types with much better algorithms;
+        // the type is fixed per kernel, so only one branch is compiled in
+        SampleType modulated = input;
+
+        if constexpr (ModType == kModChorus)
+        {
+            // Improved chorus with interpolation and feedback control
+            // Calculate delay time (3-8ms) - better range for chorus
+            SampleType delayMs = 3.0f + lfo * 5.0f;
+            SampleType delaySamplesFloat = delayMs * msToSamples;
+            int delaySamples = (int)delaySamplesFloat;
+            SampleType fraction = delaySamplesFloat - delaySamples;
+
+            // Ensure delay samples is within bounds
+            delaySamples = std::max(1, std::min(delaySamples, delayLength - 2));
+
+            // Read from delay buffer with interpolation (cubic when rendering offline)
+            int readPos = delay.delayPos - delaySamples;
+            if (readPos < 0) readPos += delayLength;
+
+            SampleType delayed = readInterpolated<Quality>(delayBuffer, delayLength, readPos, fraction);
+
+            // Conservative mixing with proper balance
+            SampleType mixAmount = modDepth * 0.15f; // Slightly increased but still conservative
+            modulated = input * (1.0f - mixAmount * 0.5f) + delayed * mixAmount;
+        }
+        else if constexpr (ModType == kModFlanger)
+        {
+            // Improved flanger with feedback and better delay range
+            // Calculate delay time (0.7-2.5ms) - better flanger range
+            SampleType delayMs = 0.7f + lfo * 1.8f;
+            SampleType delaySamplesFloat = delayMs * msToSamples;
+            int delaySamples = (int)delaySamplesFloat;
+            SampleType fraction = delaySamplesFloat - delaySamples;
+
+            // Ensure delay samples is within bounds
+            delaySamples = std::max(1, std::min(delaySamples, delayLength - 2));
+
+            // Read from delay buffer with interpolation (cubic when rendering offline)
+            int readPos = delay.delayPos - delaySamples;
+            if (readPos < 0) readPos += delayLength;
+
+            SampleType delayed = readInterpolated<Quality>(delayBuffer, delayLength, readPos, fraction);
+
+            // Add feedback for more pronounced flanger effect - using member variables
+            flangerFeedback = flangerFeedback * 0.3f + delayed * 0.7f;
+            delayed = delayed + flangerFeedback * 0.2f;
+
+            // Conservative flanging with inverted phase for sweep effect
+            SampleType mixAmount = modDepth * 0.12f;
+            modulated = input + delayed * mixAmount * (lfo > 0.5f ? 1.0f : -1.0f);
+        }
+        else if constexpr (ModType == kModPhaser)
+        {
+            // Much improved phaser with multiple allpass stages - using member variables
+            // Modulated allpass frequency
+            SampleType modAmount = modDepth * 0.08f * lfo;
+            SampleType alpha = 0.06f + modAmount * 0.04f; // Better range
+
+            // Clamp alpha for stability
+            alpha = std::max<SampleType>(0.03f, std::min<SampleType>(0.12f, alpha));
+
+            // Four-stage allpass filter cascade - using member variables
+            phaserStage1 = phaserStage1 * (1.0f - alpha) + input * alpha;
+            SampleType stage1Out = input - phaserStage1;
+
+            phaserStage2 = phaserStage2 * (1.0f - alpha) + stage1Out * alpha;
+            SampleType stage2Out = stage1Out - phaserStage2;
+
+            phaserStage3 = phaserStage3 * (1.0f - alpha) + stage2Out * alpha;
+            SampleType stage3Out = stage2Out - phaserStage3;
+
+            phaserStage4 = phaserStage4 * (1.0f - alpha) + stage3Out * alpha;
+            SampleType stage4Out = stage3Out - phaserStage4;
+
+            // Mix with feedback for more pronounced effect - using member variables
+            phaserFeedback = phaserFeedback * 0.7f + stage4Out * 0.3f;
+
+            SampleType mixAmount = modDepth * 0.08f;
+            modulated = input * (1.0f - mixAmount) +
+                       (stage4Out + phaserFeedback * 0.15f) * mixAmount;
+        }
+
+        // Gentle tanh limiting for musical saturation
+        buffer[n] = fastTanh(modulated * 0.95f) * 1.02f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Complex Reverb Algorithm: diffusion, feedback delay network, shimmer
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <int Quality>
+void EffectChain<SampleType>::processComplexReverbFrame(SampleType* frame, int32 numChannels)
+{
+    // Offline renders run the dense network laid out for them (see FdnReverb)
+    constexpr int numLines = (Quality == kQualityOffline) ? FdnReverb<SampleType>::kMaxLines
+                                                          : FdnReverb<SampleType>::kNumLines;
+
+    // Simplified allpass filter function
+    auto processAllpass = [](SampleType in, ArenaBuffer<SampleType>& buffer, int& pos, SampleType feedback) -> SampleType {
+        SampleType delayed = buffer[pos];
+        SampleType output = -in + delayed;
+        buffer[pos] = in + delayed * feedback;
+        pos = (pos + 1) % buffer.size();
+        return output;
+    };
+
+    // ===== STAGE 1: SIMPLIFIED INPUT DIFFUSION =====
+    SampleType diffused[2];
+    for (int32 channel = 0; channel < numChannels; channel++) {
+        ReverbChannelState<SampleType>& state = mReverbState[channel];
+
+        // Reduced pre-delay buffer size for less memory usage and latency (200ms)
+        int preDelaySize = (int)state.preDelayBuffer.size();
+
+        // 10-25ms pre-delay (reduced); a new size glides the tap over
+        SampleType preDelayTarget = std::max<SampleType>(1.0f, std::min<SampleType>(mCoeffs.reverbPreDelay, preDelaySize - 2));
+        state.preDelay = state.preDelayPrimed ? state.preDelay + (preDelayTarget - state.preDelay) * mCoeffs.reverbGlide
+                                              : preDelayTarget;
+        state.preDelayPrimed = true;
+
+        // Between the sample one older than the tap's whole part and the next one
+        int preDelayWhole = (int)state.preDelay;
+        int preDelayReadPos = (state.preDelayPos + preDelaySize - preDelayWhole - 1) % preDelaySize;
+        SampleType preDelayed = readInterpolated<Quality>(state.preDelayBuffer.data, preDelaySize, preDelayReadPos,
+                                                          1.0f - (state.preDelay - preDelayWhole));
+        state.preDelayBuffer[state.preDelayPos] = frame[channel];
+        state.preDelayPos = (state.preDelayPos + 1) % preDelaySize;
+
+        // Simplified input diffusion with only two allpass filters
+        diffused[channel] = processAllpass(preDelayed, state.allpass1, state.ap1pos, 0.4f);  // Further reduced feedback
+        diffused[channel] = processAllpass(diffused[channel], state.allpass2, state.ap2pos, 0.4f);
+    }
+
+    // A mono input feeds both sides of the network
+    if (numChannels == 1)
+        diffused[1] = diffused[0];
+
+    // The shimmer feeds back into the network, so each pass through it is
+    // shifted again and the octaves stack up as the tail rings
+    const bool shimmer = mCoeffs.shimmer;
+    if (shimmer) {
+        diffused[0] += mReverbState[0].shimmerReturn * mCoeffs.shimmerFeedback;
+        diffused[1] += mReverbState[numChannels - 1].shimmerReturn * mCoeffs.shimmerFeedback;
+    }
+
+    // ===== STAGE 2: FEEDBACK DELAY NETWORK =====
+    SampleType network[2];
+    mFdn.template process<numLines>(diffused, network);
+
+    // ===== STAGE 3: SHIMMER (+12 AND +5 SEMITONES) =====
+    // Granular in realtime; offline, the phase vocoder, which always runs so
+    // its frames stay filled and its latency fixed
+    SampleType shifted[2] = {};
+    if constexpr (Quality == kQualityOffline) {
+        if (numChannels >= 2)
+            mVocoderShimmer.template process<2>(network, shifted);
+        else
+            mVocoderShimmer.template process<1>(network, shifted);
+    } else if (shimmer) {
+        if (numChannels >= 2)
+            mShimmer.template process<2, false>(network, shifted);
+        else
+            mShimmer.template process<1, false>(network, shifted);
+    }
+
+    for (int32 channel = 0; channel < numChannels; channel++) {
+        ReverbChannelState<SampleType>& state = mReverbState[channel];
+        SampleType reverb = network[channel];
+
+        // Offline, the network's output always waits for the vocoder's
+        // shifted copy of it (see getReverbLatency), so the shimmer lines up
+        // whenever it comes in
+        if constexpr (Quality == kQualityOffline)
+            reverb = state.alignWet(reverb);
+
+        SampleType shimmerOutput = reverb;
+        if (shimmer) {
+            // Lowpassed to keep the stacked octaves from turning brittle
+            state.shimmerReturn = state.shimmerFilter.processSample(shifted[channel]);
+
+            SampleType shimmerAmount = mCoeffs.shimmerAmount; // Reduced intensity
+            shimmerOutput = reverb * (1.0f - shimmerAmount) + state.shimmerReturn * shimmerAmount;
+        }
+
+        // ===== STAGE 4: SIMPLIFIED FINAL OUTPUT =====
+        SampleType finalReverb = shimmerOutput;
+
+        // Single-stage gentle anti-aliasing
+        finalReverb = state.antiAliasingFilter.processSample(finalReverb);
+
+        // Gentle tanh saturation for musical character
+        finalReverb = fastTanh(finalReverb * 0.8f) * 1.1f;
+
+        // Conservative gain scaling
+        finalReverb *= 0.4f; // Increased from 0.2f for better level
+
+        frame[channel] = finalReverb;
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename SampleType>
+template <int Quality>
+SampleType EffectChain<SampleType>::readInterpolated(const SampleType* buffer, int length, int index, SampleType fraction)
+{
+    if constexpr (Quality == kQualityOffline)
+        return readCubic(buffer, length, index, fraction);
+    else
+        return readLinear(buffer, length, index, fraction);
+}
+
+//-----------------------------------------------------------------------------
+// The two engines: 32-bit and 64-bit processing
+//-----------------------------------------------------------------------------
+namespace MyVSTPlugin {
+template class EffectChain<float>;
+template class EffectChain<double>;
+} // namespace MyVSTPlugin
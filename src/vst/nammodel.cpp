@@ -0,0 +1,1093 @@
+#include "dsp/nammodel.h"
+#include "dsp/fastmath.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <locale>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace Steinberg;
+using namespace MyVSTPlugin;
+
+//-----------------------------------------------------------------------------
+// JSON
+//
+// Just enough of a parser for .nam files: the whole document becomes a tree
+// of values. Numbers are read in the classic locale, whatever the host set.
+//-----------------------------------------------------------------------------
+namespace {
+
+struct JsonValue
+{
+    enum Type { kNull = 0, kBool, kNumber, kString, kArray, kObject };
+
+    Type type = kNull;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* find(const char* key) const
+    {
+        if (type != kObject)
+            return nullptr;
+        for (const auto& member : members) {
+            if (member.first == key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser
+{
+public:
+    JsonParser(const std::string& text)
+    : mPos(text.data()), mEnd(text.data() + text.size())
+    {
+        mNumberStream.imbue(std::locale::classic());
+    }
+
+    bool parse(JsonValue& value, std::string& error)
+    {
+        skipWhitespace();
+        if (!parseValue(value, 0)) {
+            error = "invalid JSON: " + mError;
+            return false;
+        }
+        skipWhitespace();
+        if (mPos != mEnd) {
+            error = "invalid JSON: trailing characters";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    void skipWhitespace()
+    {
+        while (mPos < mEnd && (*mPos == ' ' || *mPos == '\t' || *mPos == '\n' || *mPos == '\r'))
+            mPos++;
+    }
+
+    bool fail(const char* message)
+    {
+        mError = message;
+        return false;
+    }
+
+    bool match(const char* literal)
+    {
+        const char* pos = mPos;
+        for (; *literal; literal++, pos++) {
+            if (pos == mEnd || *pos != *literal)
+                return false;
+        }
+        mPos = pos;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if (depth > kMaxDepth)
+            return fail("nested too deeply");
+        if (mPos == mEnd)
+            return fail("unexpected end");
+
+        switch (*mPos) {
+            case '{': return parseObject(value, depth);
+            case '[': return parseArray(value, depth);
+            case '"':
+                value.type = JsonValue::kString;
+                return parseString(value.string);
+            case 't':
+            case 'f':
+                value.type = JsonValue::kBool;
+                value.boolean = (*mPos == 't');
+                return match(value.boolean ? "true" : "false") || fail("unknown literal");
+            case 'n':
+                value.type = JsonValue::kNull;
+                return match("null") || fail("unknown literal");
+            default:
+                value.type = JsonValue::kNumber;
+                return parseNumber(value.number);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::kObject;
+        mPos++;
+        skipWhitespace();
+        if (mPos < mEnd && *mPos == '}') {
+            mPos++;
+            return true;
+        }
+
+        for (;;) {
+            std::string key;
+            if (mPos == mEnd || *mPos != '"' || !parseString(key))
+                return fail("expected a key");
+            skipWhitespace();
+            if (mPos == mEnd || *mPos != ':')
+                return fail("expected ':'");
+            mPos++;
+            skipWhitespace();
+
+            value.members.emplace_back(std::move(key), JsonValue());
+            if (!parseValue(value.members.back().second, depth + 1))
+                return false;
+            skipWhitespace();
+
+            if (mPos < mEnd && *mPos == ',') {
+                mPos++;
+                skipWhitespace();
+            } else if (mPos < mEnd && *mPos == '}') {
+                mPos++;
+                return true;
+            } else {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::kArray;
+        mPos++;
+        skipWhitespace();
+        if (mPos < mEnd && *mPos == ']') {
+            mPos++;
+            return true;
+        }
+
+        for (;;) {
+            value.items.emplace_back();
+            if (!parseValue(value.items.back(), depth + 1))
+                return false;
+            skipWhitespace();
+
+            if (mPos < mEnd && *mPos == ',') {
+                mPos++;
+                skipWhitespace();
+            } else if (mPos < mEnd && *mPos == ']') {
+                mPos++;
+                return true;
+            } else {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parseString(std::string& string)
+    {
+        mPos++;
+        while (mPos < mEnd && *mPos != '"') {
+            char c = *mPos++;
+            if (c != '\\') {
+                string += c;
+                continue;
+            }
+            if (mPos == mEnd)
+                break;
+
+            switch (*mPos++) {
+                case '"': string += '"'; break;
+                case '\\': string += '\\'; break;
+                case '/': string += '/'; break;
+                case 'b': string += '\b'; break;
+                case 'f': string += '\f'; break;
+                case 'n': string += '\n'; break;
+                case 'r': string += '\r'; break;
+                case 't': string += '\t'; break;
+                case 'u': {
+                    if (mEnd - mPos < 4)
+                        return fail("bad escape");
+                    unsigned code = 0;
+                    for (int i = 0; i < 4; i++) {
+                        char h = *mPos++;
+                        code <<= 4;
+                        if (h >= '0' && h <= '9') code |= h - '0';
+                        else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+                        else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+                        else return fail("bad escape");
+                    }
+                    // UTF-8; names and metadata only, so surrogates stay as they are
+                    if (code < 0x80) {
+                        string += (char)code;
+                    } else if (code < 0x800) {
+                        string += (char)(0xC0 | (code >> 6));
+                        string += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        string += (char)(0xE0 | (code >> 12));
+                        string += (char)(0x80 | ((code >> 6) & 0x3F));
+                        string += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    return fail("bad escape");
+            }
+        }
+        if (mPos == mEnd)
+            return fail("unterminated string");
+        mPos++;
+        return true;
+    }
+
+    bool parseNumber(double& number)
+    {
+        const char* start = mPos;
+        while (mPos < mEnd && (std::isdigit((unsigned char)*mPos) || *mPos == '-' || *mPos == '+' ||
+                               *mPos == '.' || *mPos == 'e' || *mPos == 'E'))
+            mPos++;
+        if (mPos == start)
+            return fail("unexpected character");
+
+        mNumberStream.clear();
+        mNumberStream.str(std::string(start, mPos));
+        mNumberStream >> number;
+        if (mNumberStream.fail() || mNumberStream.peek() != std::char_traits<char>::eof())
+            return fail("bad number");
+        return true;
+    }
+
+    const char* mPos;
+    const char* mEnd;
+    std::istringstream mNumberStream;
+    std::string mError;
+};
+
+//-----------------------------------------------------------------------------
+// Kernels
+//-----------------------------------------------------------------------------
+
+// Matrix rows are padded to whole blocks of kLanes floats (one AVX register,
+// two SSE or NEON ones), so every column starts aligned and the kernels run
+// without remainder loops
+constexpr int32 kLanes = 8;
+
+inline int32 paddedLength(int32 length)
+{
+    return (length + kLanes - 1) / kLanes * kLanes;
+}
+
+// Weights in the order the .nam file lists them
+struct WeightReader
+{
+    const std::vector<float>& weights;
+    size_t pos;
+
+    float next() { return pos < weights.size() ? weights[pos++] : (pos++, 0.0f); }
+    bool exhausted() const { return pos == weights.size(); }
+};
+
+//-----------------------------------------------------------------------------
+// PackedMatrix: Dense matrix stored column by column
+//
+// y += M x runs over the rows one block of kLanes at a time. The block of y
+// stays in registers while x[j] times each column's block is added to it, so
+// the inner loop is one aligned load and one multiply-add per column instead
+// of a strided dot product per row. Padding rows hold zeros.
+//-----------------------------------------------------------------------------
+struct PackedMatrix
+{
+    ArenaBuffer<float> data;
+    int32 rows = 0;
+    int32 cols = 0;
+    int32 stride = 0;
+
+    void layout(ProcessArena& arena, int32 numRows, int32 numCols)
+    {
+        rows = numRows;
+        cols = numCols;
+        stride = paddedLength(numRows);
+        data = arena.allocate<float>(stride * std::max<int32>(numCols, 1));
+    }
+
+    // The .nam files store matrices row by row
+    void read(WeightReader& weights)
+    {
+        data.clear();
+        for (int32 i = 0; i < rows; i++) {
+            for (int32 j = 0; j < cols; j++)
+                data[j * stride + i] = weights.next();
+        }
+    }
+
+    // y[0, stride) += M x[0, cols)
+    void multiplyAccumulate(const float* x, float* y) const
+    {
+        for (int32 r = 0; r < stride; r += kLanes) {
+            float sum[kLanes];
+            for (int32 i = 0; i < kLanes; i++)
+                sum[i] = y[r + i];
+
+            const float* column = data.data + r;
+            for (int32 j = 0; j < cols; j++, column += stride) {
+                const float xj = x[j];
+                for (int32 i = 0; i < kLanes; i++)
+                    sum[i] += column[i] * xj;
+            }
+
+            for (int32 i = 0; i < kLanes; i++)
+                y[r + i] = sum[i];
+        }
+    }
+
+    // Y += M X over a block of numSamples samples. Block rows hold one channel
+    // each, xStride and yStride floats apart. Every weight scales a whole row
+    // of X, so the inner loop runs over time with no reduction for the
+    // compiler to undo. Four rows of X go into each pass over a row of Y,
+    // which keeps the loads and stores of Y to one per four multiply-adds, and
+    // the pass runs in blocks of kLanes samples that vectorize as they stand
+    void multiplyAccumulateBlock(const float* x, int32 xStride, float* y, int32 yStride, int32 numSamples) const
+    {
+        int32 j = 0;
+        for (; j + 4 <= cols; j += 4) {
+            const float* x0 = x + j * xStride;
+            const float* x1 = x0 + xStride;
+            const float* x2 = x1 + xStride;
+            const float* x3 = x2 + xStride;
+            const float* column = data.data + j * stride;
+            for (int32 i = 0; i < rows; i++) {
+                const float w0 = column[i];
+                const float w1 = column[stride + i];
+                const float w2 = column[2 * stride + i];
+                const float w3 = column[3 * stride + i];
+                float* yi = y + i * yStride;
+                int32 n = 0;
+                for (; n + kLanes <= numSamples; n += kLanes) {
+                    float sum[kLanes];
+                    for (int32 l = 0; l < kLanes; l++)
+                        sum[l] = yi[n + l] + w0 * x0[n + l] + w1 * x1[n + l] + w2 * x2[n + l] + w3 * x3[n + l];
+                    for (int32 l = 0; l < kLanes; l++)
+                        yi[n + l] = sum[l];
+                }
+                for (; n < numSamples; n++)
+                    yi[n] = yi[n] + w0 * x0[n] + w1 * x1[n] + w2 * x2[n] + w3 * x3[n];
+            }
+        }
+
+        for (; j < cols; j++) {
+            const float* xj = x + j * xStride;
+            const float* column = data.data + j * stride;
+            for (int32 i = 0; i < rows; i++) {
+                const float w = column[i];
+                float* yi = y + i * yStride;
+                for (int32 n = 0; n < numSamples; n++)
+                    yi[n] += w * xj[n];
+            }
+        }
+    }
+};
+
+// Bias vector padded like the matrix rows it is added to
+struct PackedVector
+{
+    ArenaBuffer<float> data;
+    int32 size = 0;
+
+    void layout(ProcessArena& arena, int32 length)
+    {
+        size = length;
+        data = arena.allocate<float>(paddedLength(length));
+    }
+
+    void read(WeightReader& weights)
+    {
+        data.clear();
+        for (int32 i = 0; i < size; i++)
+            data[i] = weights.next();
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Activations
+//-----------------------------------------------------------------------------
+enum Activation
+{
+    kActivationTanh = 0,
+    kActivationFastTanh,
+    kActivationHardTanh,
+    kActivationRelu,
+    kActivationLeakyRelu,
+    kActivationSigmoid,
+    kActivationSilu,
+    kActivationHardSwish
+};
+
+bool parseActivation(const std::string& name, Activation& activation)
+{
+    static const struct { const char* name; Activation activation; } kActivations[] = {
+        {"Tanh", kActivationTanh},
+        {"Fasttanh", kActivationFastTanh},
+        {"Hardtanh", kActivationHardTanh},
+        {"ReLU", kActivationRelu},
+        {"LeakyReLU", kActivationLeakyRelu},
+        {"Sigmoid", kActivationSigmoid},
+        {"SiLU", kActivationSilu},
+        {"HardSwish", kActivationHardSwish}
+    };
+    for (const auto& entry : kActivations) {
+        if (name == entry.name) {
+            activation = entry.activation;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline float sigmoid(float x)
+{
+    return 1.0f / (1.0f + fastExp(-x));
+}
+
+// The rational tanh approximation NAM trains its "Fasttanh" models with; it
+// is part of those models, so it stays exactly as NAM defines it
+inline float namFastTanh(float x)
+{
+    const float ax = std::fabs(x);
+    const float x2 = x * x;
+    return (x * (2.45550750702956f + 2.45550750702956f * ax + (0.893229853513558f + 0.821226666969744f * ax) * x2)
+            / (2.44506634652299f + (2.44506634652299f + x2) * std::fabs(x + 0.814642734961073f * x * ax)));
+}
+
+// The switch is hoisted out of the loops, so each one stays a plain array loop
+// that vectorizes with the fast math inside
+void applyActivation(Activation activation, float* x, int32 length)
+{
+    switch (activation) {
+        case kActivationTanh:
+            for (int32 i = 0; i < length; i++) x[i] = fastTanh(x[i]);
+            break;
+        case kActivationFastTanh:
+            for (int32 i = 0; i < length; i++) x[i] = namFastTanh(x[i]);
+            break;
+        case kActivationHardTanh:
+            for (int32 i = 0; i < length; i++) x[i] = std::max(-1.0f, std::min(x[i], 1.0f));
+            break;
+        case kActivationRelu:
+            for (int32 i = 0; i < length; i++) x[i] = std::max(x[i], 0.0f);
+            break;
+        case kActivationLeakyRelu:
+            for (int32 i = 0; i < length; i++) x[i] = x[i] > 0.0f ? x[i] : 0.01f * x[i];
+            break;
+        case kActivationSigmoid:
+            for (int32 i = 0; i < length; i++) x[i] = sigmoid(x[i]);
+            break;
+        case kActivationSilu:
+            for (int32 i = 0; i < length; i++) x[i] = x[i] * sigmoid(x[i]);
+            break;
+        case kActivationHardSwish:
+            for (int32 i = 0; i < length; i++) x[i] = x[i] * std::max(0.0f, std::min(x[i] + 3.0f, 6.0f)) * (1.0f / 6.0f);
+            break;
+    }
+}
+
+// Config helpers: false when a field is missing or has the wrong type
+bool readInt(const JsonValue& object, const char* key, int32& value)
+{
+    const JsonValue* field = object.find(key);
+    if (!field || field->type != JsonValue::kNumber || field->number < 0.0 || field->number > 65536.0)
+        return false;
+    value = (int32)field->number;
+    return true;
+}
+
+bool readBool(const JsonValue& object, const char* key, bool& value)
+{
+    const JsonValue* field = object.find(key);
+    if (!field || field->type != JsonValue::kBool)
+        return false;
+    value = field->boolean;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// WaveNetModel: NAM's WaveNet
+//
+// Layer arrays of dilated convolutions. In each layer the convolution over the
+// layer input and a 1x1 mix of the condition (the dry signal) go through the
+// activation, optionally gated by a sigmoid half; the result feeds the head
+// sum and, through another 1x1, a residual update of the layer input. Each
+// array rechannels its input first and passes its head sum on to the next.
+//
+// The network runs layer by layer over the whole block rather than sample by
+// sample. Blocks are stored a channel per row, so every product, activation
+// and sum is a loop over time. Each layer appends its inputs to one line per
+// channel, and each tap of the dilated convolution reads the block shifted
+// back along those lines; they only move their tails back to the start when
+// they fill up.
+//-----------------------------------------------------------------------------
+class WaveNetModel : public NamModel
+{
+public:
+    WaveNetModel(double sampleRate) : NamModel("WaveNet", sampleRate), mHeadScale(0.0f), mReceptiveField(1) {}
+
+    bool configure(const JsonValue& config, std::string& error)
+    {
+        const JsonValue* layers = config.find("layers");
+        if (!layers || layers->type != JsonValue::kArray || layers->items.empty()) {
+            error = "WaveNet config has no layers";
+            return false;
+        }
+        const JsonValue* head = config.find("head");
+        if (head && head->type != JsonValue::kNull) {
+            error = "WaveNet heads are not supported";
+            return false;
+        }
+
+        for (const JsonValue& arrayConfig : layers->items) {
+            LayerArray array;
+            const JsonValue* dilations = arrayConfig.find("dilations");
+            const JsonValue* activation = arrayConfig.find("activation");
+            if (!readInt(arrayConfig, "input_size", array.inputSize) ||
+                !readInt(arrayConfig, "condition_size", array.conditionSize) ||
+                !readInt(arrayConfig, "head_size", array.headSize) ||
+                !readInt(arrayConfig, "channels", array.channels) ||
+                !readInt(arrayConfig, "kernel_size", array.kernelSize) ||
+                !readBool(arrayConfig, "gated", array.gated) ||
+                !readBool(arrayConfig, "head_bias", array.hasHeadBias) ||
+                !dilations || dilations->type != JsonValue::kArray || dilations->items.empty() ||
+                !activation || activation->type != JsonValue::kString)
+            {
+                error = "WaveNet layer array config is incomplete";
+                return false;
+            }
+            if (!parseActivation(activation->string, array.activation)) {
+                error = "unsupported activation " + activation->string;
+                return false;
+            }
+            if (array.channels < 1 || array.kernelSize < 1 || array.headSize < 1 || array.conditionSize != 1) {
+                error = "unsupported WaveNet layer array shape";
+                return false;
+            }
+
+            for (const JsonValue& dilation : dilations->items) {
+                if (dilation.type != JsonValue::kNumber || dilation.number < 1.0 || dilation.number > 65536.0) {
+                    error = "bad WaveNet dilation";
+                    return false;
+                }
+                Layer layer;
+                layer.dilation = (int32)dilation.number;
+                array.layers.push_back(layer);
+                mReceptiveField += (array.kernelSize - 1) * layer.dilation;
+            }
+            mArrays.push_back(std::move(array));
+        }
+
+        // Arrays chain input to input and head to head
+        if (mArrays.front().inputSize != 1 || mArrays.back().headSize != 1) {
+            error = "WaveNet must map one input to one output";
+            return false;
+        }
+        for (size_t a = 1; a < mArrays.size(); a++) {
+            if (mArrays[a].inputSize != mArrays[a - 1].channels || mArrays[a].channels != mArrays[a - 1].headSize) {
+                error = "WaveNet layer arrays do not connect";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool build(const std::vector<float>& weights, std::string& error)
+    {
+        mArena.beginLayout();
+        layoutBuffers();
+        if (!mArena.commit()) {
+            error = "out of memory";
+            return false;
+        }
+        layoutBuffers();
+
+        // Same order as the reference implementation: per array the rechannel,
+        // per layer its convolution, mixin and 1x1, then the head rechannel;
+        // the head scale comes last
+        WeightReader reader = {weights, 0};
+        for (LayerArray& array : mArrays) {
+            array.rechannel.read(reader);
+            for (Layer& layer : array.layers) {
+                readConvolution(layer, reader);
+                layer.convBias.read(reader);
+                layer.mixin.read(reader);
+                layer.output.read(reader);
+                layer.outputBias.read(reader);
+            }
+            array.headRechannel.read(reader);
+            if (array.hasHeadBias)
+                array.headBias.read(reader);
+        }
+        mHeadScale = reader.next();
+
+        if (!reader.exhausted()) {
+            error = "weight count does not match the WaveNet config";
+            return false;
+        }
+
+        reset();
+        return true;
+    }
+
+    void reset() override
+    {
+        for (LayerArray& array : mArrays) {
+            for (Layer& layer : array.layers) {
+                for (int32 ch = 0; ch < kMaxChannels; ch++) {
+                    layer.history[ch].clear();
+                    layer.historyPos[ch] = layer.span;
+                }
+            }
+        }
+
+        // Fill the receptive field with the network's response to silence
+        for (int32 ch = 0; ch < kMaxChannels; ch++) {
+            for (int32 done = 0; done < mReceptiveField; done += kMaxBlockSize) {
+                int32 count = std::min(kMaxBlockSize, mReceptiveField - done);
+                std::fill(mPrewarm.begin(), mPrewarm.begin() + count, 0.0f);
+                process(ch, mPrewarm.data, count);
+            }
+        }
+    }
+
+    void process(int channel, float* buffer, int32 numSamples) override
+    {
+        // The dry signal is the first array's input and every layer's
+        // condition; all block rows are numSamples long
+        const int32 n = numSamples;
+        const float* condition = buffer;
+        const float* arrayInput = condition;
+        float* layerInput = mLayerInput[0].data;
+        float* headSum = mHeadSum[0].data;
+
+        for (size_t a = 0; a < mArrays.size(); a++) {
+            LayerArray& array = mArrays[a];
+
+            std::fill(layerInput, layerInput + array.channels * n, 0.0f);
+            array.rechannel.multiplyAccumulateBlock(arrayInput, n, layerInput, n, n);
+
+            // The first array starts the head sum from zero, later ones
+            // from the head of the array before
+            if (a == 0)
+                std::fill(headSum, headSum + array.channels * n, 0.0f);
+
+            for (Layer& layer : array.layers)
+                processLayer(array, layer, channel, layerInput, condition, headSum, n);
+
+            // Ping-pong, so the next array reads this one's outputs
+            float* headOut = (headSum == mHeadSum[0].data) ? mHeadSum[1].data : mHeadSum[0].data;
+            for (int32 i = 0; i < array.headSize; i++)
+                std::fill(headOut + i * n, headOut + (i + 1) * n, array.hasHeadBias ? array.headBias.data[i] : 0.0f);
+            array.headRechannel.multiplyAccumulateBlock(headSum, n, headOut, n, n);
+
+            arrayInput = layerInput;
+            layerInput = (layerInput == mLayerInput[0].data) ? mLayerInput[1].data : mLayerInput[0].data;
+            headSum = headOut;
+        }
+
+        for (int32 i = 0; i < n; i++)
+            buffer[i] = mHeadScale * headSum[i];
+    }
+
+private:
+    struct Layer
+    {
+        int32 dilation = 1;
+        std::vector<PackedMatrix> conv;          // One matrix per tap, oldest tap first
+        PackedVector convBias;
+        PackedMatrix mixin;                      // Condition into the convolution output
+        PackedMatrix output;                     // 1x1 back to the residual channels
+        PackedVector outputBias;
+        ArenaBuffer<float> history[kMaxChannels]; // Past layer inputs, a line per layer channel
+        int32 span = 0;                          // Samples the oldest tap looks back
+        int32 historyLength = 0;                 // Length of each line
+        int32 historyPos[kMaxChannels] = {};     // Where the next block is written
+    };
+
+    struct LayerArray
+    {
+        int32 inputSize = 0;
+        int32 conditionSize = 0;
+        int32 headSize = 0;
+        int32 channels = 0;
+        int32 kernelSize = 0;
+        Activation activation = kActivationTanh;
+        bool gated = false;
+        bool hasHeadBias = false;
+        PackedMatrix rechannel;
+        std::vector<Layer> layers;
+        PackedMatrix headRechannel;
+        PackedVector headBias;
+    };
+
+    void layoutBuffers()
+    {
+        int32 maxRows = 0;
+        for (LayerArray& array : mArrays) {
+            const int32 channels = array.channels;
+            const int32 convChannels = array.gated ? 2 * channels : channels;
+            maxRows = std::max(maxRows, convChannels);
+            maxRows = std::max(maxRows, array.headSize);
+
+            array.rechannel.layout(mArena, channels, array.inputSize);
+            for (Layer& layer : array.layers) {
+                layer.conv.resize(array.kernelSize);
+                for (PackedMatrix& tap : layer.conv)
+                    tap.layout(mArena, convChannels, channels);
+                layer.convBias.layout(mArena, convChannels);
+                layer.mixin.layout(mArena, convChannels, array.conditionSize);
+                layer.output.layout(mArena, channels, channels);
+                layer.outputBias.layout(mArena, channels);
+
+                // Room for the span twice over, so the tail only moves back
+                // once every span samples or so
+                layer.span = (array.kernelSize - 1) * layer.dilation;
+                layer.historyLength = 2 * layer.span + kMaxBlockSize;
+                for (int32 ch = 0; ch < kMaxChannels; ch++)
+                    layer.history[ch] = mArena.allocate<float>(layer.historyLength * channels);
+            }
+            array.headRechannel.layout(mArena, array.headSize, channels);
+            array.headBias.layout(mArena, array.headSize);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            mLayerInput[i] = mArena.allocate<float>(kMaxBlockSize * maxRows);
+            mHeadSum[i] = mArena.allocate<float>(kMaxBlockSize * maxRows);
+        }
+        mConv = mArena.allocate<float>(kMaxBlockSize * maxRows);
+        mPrewarm = mArena.allocate<float>(kMaxBlockSize);
+    }
+
+    // Convolution weights are listed output, input, tap
+    static void readConvolution(Layer& layer, WeightReader& reader)
+    {
+        const int32 kernelSize = (int32)layer.conv.size();
+        const int32 rows = layer.conv[0].rows;
+        const int32 cols = layer.conv[0].cols;
+        for (PackedMatrix& tap : layer.conv)
+            tap.data.clear();
+        for (int32 i = 0; i < rows; i++) {
+            for (int32 j = 0; j < cols; j++) {
+                for (int32 k = 0; k < kernelSize; k++)
+                    layer.conv[k].data[j * layer.conv[k].stride + i] = reader.next();
+            }
+        }
+    }
+
+    void processLayer(const LayerArray& array, Layer& layer, int channel,
+                      float* layerInput, const float* condition, float* headSum, int32 numSamples)
+    {
+        const int32 n = numSamples;
+        const int32 channels = array.channels;
+        const int32 length = layer.historyLength;
+        const int32 kernelSize = (int32)layer.conv.size();
+        float* history = layer.history[channel].data;
+
+        // Append the block, moving the span it still needs to the start when full
+        int32& pos = layer.historyPos[channel];
+        if (pos + n > length) {
+            for (int32 j = 0; j < channels; j++) {
+                float* line = history + j * length;
+                std::copy(line + pos - layer.span, line + pos, line);
+            }
+            pos = layer.span;
+        }
+        for (int32 j = 0; j < channels; j++)
+            std::copy(layerInput + j * n, layerInput + (j + 1) * n, history + j * length + pos);
+        const float* block = history + pos;
+        pos += n;
+
+        // Dilated convolution: tap k looks (kernelSize - 1 - k) * dilation
+        // samples back, so it is one product over the block shifted that far
+        const int32 convChannels = layer.convBias.size;
+        float* z = mConv.data;
+        for (int32 i = 0; i < convChannels; i++)
+            std::fill(z + i * n, z + (i + 1) * n, layer.convBias.data[i]);
+        for (int32 k = 0; k < kernelSize; k++)
+            layer.conv[k].multiplyAccumulateBlock(block - (kernelSize - 1 - k) * layer.dilation, length, z, n, n);
+        layer.mixin.multiplyAccumulateBlock(condition, n, z, n, n);
+
+        // Activation, gated by a sigmoid of the second half
+        applyActivation(array.activation, z, channels * n);
+        if (array.gated) {
+            float* gate = z + channels * n;
+            applyActivation(kActivationSigmoid, gate, channels * n);
+            for (int32 i = 0; i < channels * n; i++)
+                z[i] *= gate[i];
+        }
+
+        for (int32 i = 0; i < channels * n; i++)
+            headSum[i] += z[i];
+
+        // Residual update through the 1x1
+        for (int32 i = 0; i < channels; i++) {
+            const float bias = layer.outputBias.data[i];
+            float* row = layerInput + i * n;
+            for (int32 t = 0; t < n; t++)
+                row[t] += bias;
+        }
+        layer.output.multiplyAccumulateBlock(z, n, layerInput, n, n);
+    }
+
+    std::vector<LayerArray> mArrays;
+    float mHeadScale;
+    int32 mReceptiveField;              // Samples the output depends on
+
+    // Scratch, shared by the channels as they run one after the other
+    ArenaBuffer<float> mLayerInput[2];  // Residual stream of the block, ping-pong between arrays
+    ArenaBuffer<float> mHeadSum[2];     // Head sums of the block, ping-pong between arrays
+    ArenaBuffer<float> mConv;           // Convolution output of the running layer over the block
+    ArenaBuffer<float> mPrewarm;        // Silence for reset()
+};
+
+//-----------------------------------------------------------------------------
+// LstmModel: NAM's LSTM
+//
+// Stacked LSTM cells and a linear head. Each cell keeps its input and hidden
+// state in one vector, so all four gates come out of a single matrix-vector
+// product; the gates are stored one after the other (input, forget, cell,
+// output), which keeps the state update a set of contiguous loops.
+//-----------------------------------------------------------------------------
+class LstmModel : public NamModel
+{
+public:
+    // The reference implementation lets the cells settle for half a second
+    static constexpr double kPrewarmSeconds = 0.5;
+
+    LstmModel(double sampleRate) : NamModel("LSTM", sampleRate), mHeadBias(0.0f) {}
+
+    bool configure(const JsonValue& config, std::string& error)
+    {
+        int32 inputSize = 0;
+        int32 hiddenSize = 0;
+        int32 numLayers = 0;
+        if (!readInt(config, "input_size", inputSize) ||
+            !readInt(config, "hidden_size", hiddenSize) ||
+            !readInt(config, "num_layers", numLayers))
+        {
+            error = "LSTM config is incomplete";
+            return false;
+        }
+        if (inputSize != 1 || hiddenSize < 1 || numLayers < 1) {
+            error = "unsupported LSTM shape";
+            return false;
+        }
+
+        mCells.resize(numLayers);
+        for (int32 l = 0; l < numLayers; l++) {
+            mCells[l].inputSize = (l == 0) ? inputSize : hiddenSize;
+            mCells[l].hiddenSize = hiddenSize;
+        }
+        return true;
+    }
+
+    bool build(const std::vector<float>& weights, std::string& error)
+    {
+        mArena.beginLayout();
+        layoutBuffers();
+        if (!mArena.commit()) {
+            error = "out of memory";
+            return false;
+        }
+        layoutBuffers();
+
+        // Per cell the gate matrix over [input, hidden], the gate bias and the
+        // initial hidden and cell state; the head comes last
+        WeightReader reader = {weights, 0};
+        for (Cell& cell : mCells) {
+            cell.gates.read(reader);
+            cell.bias.read(reader);
+            cell.initialHidden.read(reader);
+            cell.initialCell.read(reader);
+        }
+        mHeadWeights.read(reader);
+        mHeadBias = reader.next();
+
+        if (!reader.exhausted()) {
+            error = "weight count does not match the LSTM config";
+            return false;
+        }
+
+        mPrewarmSamples = (int32)(kPrewarmSeconds * (mSampleRate > 0.0 ? mSampleRate : 48000.0));
+        reset();
+        return true;
+    }
+
+    void reset() override
+    {
+        for (Cell& cell : mCells) {
+            for (int32 ch = 0; ch < kMaxChannels; ch++) {
+                cell.inputHidden[ch].clear();
+                std::copy(cell.initialHidden.data.data, cell.initialHidden.data.data + cell.hiddenSize,
+                          cell.inputHidden[ch].data + cell.inputSize);
+                std::copy(cell.initialCell.data.data, cell.initialCell.data.data + cell.hiddenSize,
+                          cell.cellState[ch].data);
+            }
+        }
+
+        for (int32 ch = 0; ch < kMaxChannels; ch++) {
+            for (int32 done = 0; done < mPrewarmSamples; done += kMaxBlockSize) {
+                int32 count = std::min(kMaxBlockSize, mPrewarmSamples - done);
+                std::fill(mPrewarm.begin(), mPrewarm.begin() + count, 0.0f);
+                process(ch, mPrewarm.data, count);
+            }
+        }
+    }
+
+    void process(int channel, float* buffer, int32 numSamples) override
+    {
+        for (int32 n = 0; n < numSamples; n++) {
+            const float* input = buffer + n;
+            for (Cell& cell : mCells)
+                input = processCell(cell, channel, input);
+
+            float output = mHeadBias;
+            for (int32 i = 0; i < mHeadWeights.size; i++)
+                output += mHeadWeights.data[i] * input[i];
+            buffer[n] = output;
+        }
+    }
+
+private:
+    struct Cell
+    {
+        int32 inputSize = 0;
+        int32 hiddenSize = 0;
+        PackedMatrix gates;                          // 4 * hidden rows over [input, hidden]
+        PackedVector bias;
+        PackedVector initialHidden;
+        PackedVector initialCell;
+        ArenaBuffer<float> inputHidden[kMaxChannels]; // [input, hidden] of the last step
+        ArenaBuffer<float> cellState[kMaxChannels];
+    };
+
+    void layoutBuffers()
+    {
+        int32 maxGates = 0;
+        for (Cell& cell : mCells) {
+            const int32 numGates = 4 * cell.hiddenSize;
+            maxGates = std::max(maxGates, paddedLength(numGates));
+
+            cell.gates.layout(mArena, numGates, cell.inputSize + cell.hiddenSize);
+            cell.bias.layout(mArena, numGates);
+            cell.initialHidden.layout(mArena, cell.hiddenSize);
+            cell.initialCell.layout(mArena, cell.hiddenSize);
+            for (int32 ch = 0; ch < kMaxChannels; ch++) {
+                cell.inputHidden[ch] = mArena.allocate<float>(cell.inputSize + cell.hiddenSize);
+                cell.cellState[ch] = mArena.allocate<float>(cell.hiddenSize);
+            }
+        }
+        mHeadWeights.layout(mArena, mCells.empty() ? 1 : mCells.back().hiddenSize);
+        mGates = mArena.allocate<float>(maxGates);
+        mPrewarm = mArena.allocate<float>(kMaxBlockSize);
+    }
+
+    // One time step; returns the new hidden state
+    const float* processCell(Cell& cell, int channel, const float* input)
+    {
+        const int32 hidden = cell.hiddenSize;
+        float* inputHidden = cell.inputHidden[channel].data;
+        float* state = cell.cellState[channel].data;
+        float* gates = mGates.data;
+
+        std::copy(input, input + cell.inputSize, inputHidden);
+        std::copy(cell.bias.data.begin(), cell.bias.data.end(), gates);
+        cell.gates.multiplyAccumulate(inputHidden, gates);
+
+        applyActivation(kActivationSigmoid, gates, 2 * hidden);              // Input and forget
+        applyActivation(kActivationTanh, gates + 2 * hidden, hidden);        // Cell
+        applyActivation(kActivationSigmoid, gates + 3 * hidden, hidden);     // Output
+
+        float* h = inputHidden + cell.inputSize;
+        for (int32 i = 0; i < hidden; i++)
+            state[i] = gates[hidden + i] * state[i] + gates[i] * gates[2 * hidden + i];
+        for (int32 i = 0; i < hidden; i++)
+            h[i] = gates[3 * hidden + i] * fastTanh(state[i]);
+        return h;
+    }
+
+    std::vector<Cell> mCells;
+    PackedVector mHeadWeights;
+    float mHeadBias;
+    int32 mPrewarmSamples = 0;
+
+    ArenaBuffer<float> mGates;     // Gate pre-activations of the running cell
+    ArenaBuffer<float> mPrewarm;   // Silence for reset()
+};
+
+// Build one architecture from its config and weights
+template <typename Model>
+NamModel* buildModel(double sampleRate, const JsonValue& config, const std::vector<float>& weights, std::string& error)
+{
+    std::unique_ptr<Model> model(new Model(sampleRate));
+    if (!model->configure(config, error) || !model->build(weights, error))
+        return nullptr;
+    return model.release();
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+NamModel* NamModel::load(const char* path, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = std::string("cannot open ") + path;
+        return nullptr;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return parse(contents.str(), error);
+}
+
+//-----------------------------------------------------------------------------
+NamModel* NamModel::parse(const std::string& json, std::string& error)
+{
+    JsonValue root;
+    if (!JsonParser(json).parse(root, error))
+        return nullptr;
+
+    const JsonValue* architecture = root.find("architecture");
+    const JsonValue* config = root.find("config");
+    const JsonValue* weightValues = root.find("weights");
+    if (!architecture || architecture->type != JsonValue::kString ||
+        !config || config->type != JsonValue::kObject ||
+        !weightValues || weightValues->type != JsonValue::kArray)
+    {
+        error = "not a .nam model";
+        return nullptr;
+    }
+
+    std::vector<float> weights;
+    weights.reserve(weightValues->items.size());
+    for (const JsonValue& weight : weightValues->items) {
+        if (weight.type != JsonValue::kNumber) {
+            error = "weights must be numbers";
+            return nullptr;
+        }
+        weights.push_back((float)weight.number);
+    }
+
+    // Older files do not record the rate they were trained at
+    double sampleRate = 0.0;
+    const JsonValue* rate = root.find("sample_rate");
+    if (rate && rate->type == JsonValue::kNumber)
+        sampleRate = rate->number;
+
+    if (architecture->string == "WaveNet")
+        return buildModel<WaveNetModel>(sampleRate, *config, weights, error);
+    if (architecture->string == "LSTM")
+        return buildModel<LstmModel>(sampleRate, *config, weights, error);
+
+    error = "unsupported architecture " + architecture->string;
+    return nullptr;
+}
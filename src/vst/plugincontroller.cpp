@@ -1,9 +1,12 @@
 #include "plugincontroller.h"
 #include "pluginids.h"
+#include "effectchain.h"
 #include "plugineditor.h"
 
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/base/ustring.h"
+#include "pluginterfaces/vst/ivstmessage.h"
+#include <cstring>
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
@@ -35,6 +38,13 @@ PluginController::PluginController()
 , mModType(kModChorus)
 , mModRate(0.5f)
 , mModDepth(0.5f)
+, mOversampling(kOversampling1x)
+, mAmpModel(kAmpModelBuiltIn)
+, mDistAntialias(kDistAntialiasOff)
+, mCabinet(0.0f)
+, mSampleRate(44100.0)
+, mQuality(EffectChainBase::kQualityRealtime)
+, mLatency(0)
 {
     // Initialize parameters
 }
@@ -108,6 +118,12 @@ tresult PLUGIN_API PluginController::setComponentState(IBStream* state)
     float savedModRate = 0.5f;
     float savedModDepth = 0.5f;
     
+    int32 savedOversampling = kOversampling1x;
+    int32 savedAmpModel = kAmpModelBuiltIn;
+    
+    int32 savedDistAntialias = kDistAntialiasOff;
+    float savedCabinet = 0.0f;
+    
     // Read all parameters (with error checking)
     if (streamer.readFloat(savedAmpBypass) == false ||
         streamer.readFloat(savedDistBypass) == false ||
@@ -142,6 +158,24 @@ tresult PLUGIN_API PluginController::setComponentState(IBStream* state)
         return kResultFalse;
     }
     
+    // States saved before oversampling existed end here
+    if (streamer.readInt32(savedOversampling) == false)
+        savedOversampling = kOversampling1x;
+    
+    // ...and these before the amp model (the model file itself is the processor's)
+    if (streamer.readInt32(savedAmpModel) == false)
+        savedAmpModel = kAmpModelBuiltIn;
+    
+    // ...and these before distortion antialiasing, which follows the model path
+    char8* savedModelPath = streamer.readStr8();
+    delete[] savedModelPath;
+    if (streamer.readInt32(savedDistAntialias) == false)
+        savedDistAntialias = kDistAntialiasOff;
+    
+    // ...and these before the cabinet switch
+    if (streamer.readFloat(savedCabinet) == false)
+        savedCabinet = 0.0f;
+    
     // Update the parameters
     setParamNormalized(kParamAmpBypassId, savedAmpBypass);
     setParamNormalized(kParamDistBypassId, savedDistBypass);
@@ -156,7 +190,7 @@ tresult PLUGIN_API PluginController::setComponentState(IBStream* state)
     setParamNormalized(kParamPresenceId, savedPresence);
     setParamNormalized(kParamOutputLevelId, savedOutputLevel);
     
-    setParamNormalized(kParamDistTypeId, (float)savedDistType / (float)(kNumDistTypes - 1));
+    setParamNormalized(kParamDistTypeId, distTypeToNormalized(savedDistType));
     setParamNormalized(kParamDistDriveId, savedDistDrive);
     
     setParamNormalized(kParamReverbMixId, savedReverbMix);
@@ -173,6 +207,14 @@ tresult PLUGIN_API PluginController::setComponentState(IBStream* state)
     setParamNormalized(kParamModRateId, savedModRate);
     setParamNormalized(kParamModDepthId, savedModDepth);
     
+    setParamNormalized(kParamOversamplingId, (float)savedOversampling / (float)(kNumOversamplingFactors - 1));
+    
+    setParamNormalized(kParamAmpModelId, (float)savedAmpModel / (float)(kNumAmpModels - 1));
+    
+    setParamNormalized(kParamDistAntialiasId, (float)savedDistAntialias / (float)(kNumDistAntialiasModes - 1));
+    
+    setParamNormalized(kParamCabinetId, savedCabinet);
+    
     // Store values locally
     mAmpBypass = savedAmpBypass;
     mDistBypass = savedDistBypass;
@@ -204,6 +246,11 @@ tresult PLUGIN_API PluginController::setComponentState(IBStream* state)
     mModRate = savedModRate;
     mModDepth = savedModDepth;
     
+    mOversampling = savedOversampling;
+    mAmpModel = savedAmpModel;
+    mDistAntialias = savedDistAntialias;
+    mCabinet = savedCabinet;
+    
     return kResultOk;
 }
 
@@ -268,7 +315,7 @@ tresult PLUGIN_API PluginController::setParamNormalized(ParamID tag, ParamValue
             
         // Distortion Section
         case kParamDistTypeId:
-            mDistType = (int)(value * (kNumDistTypes - 1) + 0.5f);
+            mDistType = distTypeFromNormalized(value);
             break;
         case kParamDistDriveId:
             mDistDrive = value;
@@ -312,11 +359,78 @@ tresult PLUGIN_API PluginController::setParamNormalized(ParamID tag, ParamValue
         case kParamModDepthId:
             mModDepth = value;
             break;
+            
+        // Quality
+        case kParamOversamplingId:
+            mOversampling = (int)(value * (kNumOversamplingFactors - 1) + 0.5f);
+            break;
+            
+        // Amp Model
+        case kParamAmpModelId:
+            mAmpModel = (int)(value * (kNumAmpModels - 1) + 0.5f);
+            break;
+            
+        // Distortion Antialiasing
+        case kParamDistAntialiasId:
+            mDistAntialias = (int)(value * (kNumDistAntialiasModes - 1) + 0.5f);
+            break;
+            
+        // Cabinet
+        case kParamCabinetId:
+            mCabinet = value;
+            break;
     }
     
+    // The oversampling factor and the reverse reverb change the latency
+    updateLatency();
+    
     return result;
 }
 
+//-----------------------------------------------------------------------------
+tresult PLUGIN_API PluginController::notify(IMessage* message)
+{
+    if (!message)
+        return kInvalidArgument;
+
+    if (FIDStringsEqual(message->getMessageID(), kMsgProcessSetup))
+    {
+        // The processor was set up for a new rate or processing mode
+        double sampleRate = mSampleRate;
+        int64 quality = mQuality;
+        if (!message->getAttributes() ||
+            message->getAttributes()->getFloat(kMsgAttrSampleRate, sampleRate) != kResultOk ||
+            message->getAttributes()->getInt(kMsgAttrQuality, quality) != kResultOk)
+            return kResultFalse;
+
+        mSampleRate = sampleRate;
+        mQuality = (quality == EffectChainBase::kQualityOffline) ? EffectChainBase::kQualityOffline
+                                                                 : EffectChainBase::kQualityRealtime;
+        updateLatency();
+        return kResultOk;
+    }
+
+    return EditControllerEx1::notify(message);
+}
+
+//-----------------------------------------------------------------------------
+void PluginController::updateLatency()
+{
+    // Same figure as PluginProcessor::getLatencySamples(); the host only
+    // re-reads it when asked to
+    ChainParameters params;
+    params.oversampling = mOversampling;
+    params.reverbReverse = mReverbReverse;
+
+    int32 latency = EffectChainBase::getLatency(params, mSampleRate, mQuality);
+    if (latency == mLatency)
+        return;
+
+    mLatency = latency;
+    if (componentHandler)
+        componentHandler->restartComponent(kLatencyChanged);
+}
+
 //-----------------------------------------------------------------------------
 tresult PLUGIN_API PluginController::getState(IBStream* state)
 {
@@ -331,6 +445,24 @@ tresult PLUGIN_API PluginController::setState(IBStream* state)
     return kResultOk;
 }
 
+//-----------------------------------------------------------------------------
+tresult PluginController::loadAmpModel(const char* path)
+{
+    // The processor owns the model; the path is all that crosses over
+    if (!path || path[0] == 0)
+        return kInvalidArgument;
+
+    IMessage* message = allocateMessage();
+    if (!message)
+        return kResultFalse;
+
+    message->setMessageID(kMsgLoadAmpModel);
+    message->getAttributes()->setBinary(kMsgAttrPath, path, (uint32)strlen(path));
+    tresult result = sendMessage(message);
+    message->release();
+    return result;
+}
+
 //-----------------------------------------------------------------------------
 void PluginController::setupParameters()
 {
@@ -488,8 +620,10 @@ void PluginController::setupParameters()
         nullptr,                  // Parameter title for displaying
         ParameterInfo::kCanAutomate | ParameterInfo::kIsList // Flags
     );
-    distTypeParam->appendString(STR16("Clean"));
+    distTypeParam->appendString(STR16("Clean"));         // In kDistTypeListOrder
+    distTypeParam->appendString(STR16("Asymmetric"));
     distTypeParam->appendString(STR16("Crunch"));
+    distTypeParam->appendString(STR16("Octave Fuzz"));
     distTypeParam->appendString(STR16("Fuzz"));
     parameters.addParameter(distTypeParam);
     
@@ -527,12 +661,13 @@ void PluginController::setupParameters()
         STR16("Reverb")           // Parameter group
     );
     
+    // Not automatable: the reverse swell's convolution moves the latency
     parameters.addParameter(
         STR16("Reverse"),         // Parameter title
         STR16(""),                // Parameter unit
         1,                        // Step count (1 = toggle)
         0.0,                      // Default normalized value
-        ParameterInfo::kCanAutomate, // Flags
+        ParameterInfo::kNoFlags,  // Flags
         kParamReverbReverseId,    // Parameter ID
         3,                        // Unit ID (Reverb)
         STR16("Reverb")           // Parameter group
@@ -627,4 +762,57 @@ void PluginController::setupParameters()
         5,                        // Unit ID (Modulation)
         STR16("Modulation")       // Parameter group
     );
+    
+    // Quality Parameters (not automatable: every change moves the latency)
+    StringListParameter* oversamplingParam = new StringListParameter(
+        STR16("Oversampling"),    // Parameter title
+        kParamOversamplingId,     // Parameter ID
+        nullptr,                  // Parameter title for displaying
+        ParameterInfo::kIsList,   // Flags
+        1                         // Unit ID (Amp)
+    );
+    oversamplingParam->appendString(STR16("1x"));
+    oversamplingParam->appendString(STR16("2x"));
+    oversamplingParam->appendString(STR16("4x"));
+    oversamplingParam->appendString(STR16("8x"));
+    parameters.addParameter(oversamplingParam);
+    
+    // Amp Model Parameters (captured falls back to built-in until a model is
+    // loaded, and while the host rate isn't the one it was trained at)
+    StringListParameter* ampModelParam = new StringListParameter(
+        STR16("Amp Model"),       // Parameter title
+        kParamAmpModelId,         // Parameter ID
+        nullptr,                  // Parameter title for displaying
+        ParameterInfo::kCanAutomate | ParameterInfo::kIsList, // Flags
+        1                         // Unit ID (Amp)
+    );
+    ampModelParam->appendString(STR16("Built-in"));
+    ampModelParam->appendString(STR16("Captured"));
+    ampModelParam->appendString(STR16("Triode"));
+    parameters.addParameter(ampModelParam);
+    
+    // Distortion Antialiasing Parameters (an alternative to oversampling at 1x)
+    StringListParameter* distAntialiasParam = new StringListParameter(
+        STR16("Antialias"),       // Parameter title
+        kParamDistAntialiasId,    // Parameter ID
+        nullptr,                  // Parameter title for displaying
+        ParameterInfo::kCanAutomate | ParameterInfo::kIsList, // Flags
+        2                         // Unit ID (Distortion)
+    );
+    distAntialiasParam->appendString(STR16("Off"));
+    distAntialiasParam->appendString(STR16("ADAA 1"));
+    distAntialiasParam->appendString(STR16("ADAA 2"));
+    parameters.addParameter(distAntialiasParam);
+    
+    // Cabinet Parameters (off by default, so the amps keep their voicing)
+    parameters.addParameter(
+        STR16("Cabinet"),         // Parameter title
+        STR16(""),                // Parameter unit
+        1,                        // Step count (1 = toggle)
+        0.0,                      // Default normalized value
+        ParameterInfo::kCanAutomate, // Flags
+        kParamCabinetId,          // Parameter ID
+        1,                        // Unit ID (Amp)
+        STR16("Cabinet")          // Parameter group
+    );
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #if SMTG_OS_WINDOWS
 #include <windowsx.h> // For GET_X_LPARAM and GET_Y_LPARAM
+#include <commdlg.h>  // For GetOpenFileNameA
 #endif
 
 using namespace Steinberg;
@@ -98,11 +99,19 @@ void PluginEditor::initializeGUI()
     mKnobs.push_back({220, 120, kParamMidId, "Mid", 0.5f});
     mKnobs.push_back({300, 120, kParamTrebleId, "Treble", 0.5f});
     mKnobs.push_back({380, 120, kParamPresenceId, "Presence", 0.5f});
+    mKnobs.push_back({500, 120, kParamOversamplingId, "Oversample", 0.0f});
     mKnobs.push_back({620, 120, kParamOutputLevelId, "Level", 0.7f});
     
     // Distortion section - horizontal layout
     mKnobs.push_back({60, 240, kParamDistTypeId, "Type", 0.5f});
     mKnobs.push_back({180, 240, kParamDistDriveId, "Drive", 0.5f});
+    mKnobs.push_back({620, 240, kParamDistAntialiasId, "Antialias", 0.0f});
+    
+    // Amp model selection - next to the distortion, clicking "Built-in" loads a capture
+    mKnobs.push_back({500, 240, kParamAmpModelId, "Amp Model", 0.0f});
+    
+    // Cabinet switch - under the amp bypass
+    mKnobs.push_back({750, 240, kParamCabinetId, "Cabinet", 0.0f});
     
     // Reverb section - horizontal layout
     mKnobs.push_back({60, 360, kParamReverbMixId, "Mix", 0.3f});
@@ -374,8 +383,12 @@ void PluginEditor::paint(HDC hdc)
                         mKnobs[i].paramId == kParamModBypassId ||
                         mKnobs[i].paramId == kParamReverbReverseId ||
                         mKnobs[i].paramId == kParamDelayReverseId ||
+                        mKnobs[i].paramId == kParamCabinetId ||
                         mKnobs[i].paramId == kParamDistTypeId ||
-                        mKnobs[i].paramId == kParamModTypeId);
+                        mKnobs[i].paramId == kParamModTypeId ||
+                        mKnobs[i].paramId == kParamOversamplingId ||
+                        mKnobs[i].paramId == kParamAmpModelId ||
+                        mKnobs[i].paramId == kParamDistAntialiasId);
         
         HBRUSH controlBrush;
         HBRUSH oldBrush;
@@ -396,14 +409,18 @@ void PluginEditor::paint(HDC hdc)
             }
             // For toggle buttons, show green when active
             else if (mKnobs[i].paramId == kParamReverbReverseId ||
-                     mKnobs[i].paramId == kParamDelayReverseId) {
+                     mKnobs[i].paramId == kParamDelayReverseId ||
+                     mKnobs[i].paramId == kParamCabinetId) {
                 if (mKnobs[i].value > 0.5f) {
                     buttonColor = RGB(50, 200, 50); // Green when active
                 }
             }
             // For mode selection, highlight current selection
             else if (mKnobs[i].paramId == kParamDistTypeId ||
-                     mKnobs[i].paramId == kParamModTypeId) {
+                     mKnobs[i].paramId == kParamModTypeId ||
+                     mKnobs[i].paramId == kParamOversamplingId ||
+                     mKnobs[i].paramId == kParamAmpModelId ||
+                     mKnobs[i].paramId == kParamDistAntialiasId) {
                 if (i == mDraggingKnob) {
                     buttonColor = COLOR_KNOB_HIGHLIGHT;
                 }
@@ -476,12 +493,14 @@ void PluginEditor::paint(HDC hdc)
         // Special handling for enum parameters
         if (mKnobs[i].paramId == kParamDistTypeId)
         {
-            int distType = (int)(mKnobs[i].value * 2.0f + 0.5f);
+            int distType = distTypeFromNormalized(mKnobs[i].value);
             switch (distType)
             {
-                case 0: valueText = L"Clean"; break;
-                case 1: valueText = L"Crunch"; break;
-                case 2: valueText = L"Fuzz"; break;
+                case kDistClean: valueText = L"Clean"; break;
+                case kDistCrunch: valueText = L"Crunch"; break;
+                case kDistFuzz: valueText = L"Fuzz"; break;
+                case kDistAsymmetric: valueText = L"Asymmetric"; break;
+                case kDistOctaveFuzz: valueText = L"Octave Fuzz"; break;
                 default: valueText = L"Unknown";
             }
         }
@@ -496,7 +515,41 @@ void PluginEditor::paint(HDC hdc)
                 default: valueText = L"Unknown";
             }
         }
-        else if (mKnobs[i].paramId == kParamReverbReverseId || mKnobs[i].paramId == kParamDelayReverseId)
+        else if (mKnobs[i].paramId == kParamOversamplingId)
+        {
+            int oversampling = (int)(mKnobs[i].value * 3.0f + 0.5f);
+            switch (oversampling)
+            {
+                case 0: valueText = L"1x"; break;
+                case 1: valueText = L"2x"; break;
+                case 2: valueText = L"4x"; break;
+                case 3: valueText = L"8x"; break;
+                default: valueText = L"Unknown";
+            }
+        }
+        else if (mKnobs[i].paramId == kParamDistAntialiasId)
+        {
+            int antialias = (int)(mKnobs[i].value * (kNumDistAntialiasModes - 1) + 0.5f);
+            switch (antialias)
+            {
+                case kDistAntialiasOff: valueText = L"Off"; break;
+                case kDistAntialiasAdaa1: valueText = L"ADAA 1"; break;
+                case kDistAntialiasAdaa2: valueText = L"ADAA 2"; break;
+                default: valueText = L"Unknown";
+            }
+        }
+        else if (mKnobs[i].paramId == kParamAmpModelId)
+        {
+            switch ((int)(mKnobs[i].value * (kNumAmpModels - 1) + 0.5f))
+            {
+                case kAmpModelBuiltIn: valueText = L"Built-in"; break;
+                case kAmpModelCaptured: valueText = L"Captured"; break;
+                case kAmpModelTriode: valueText = L"Triode"; break;
+                default: valueText = L"Unknown";
+            }
+        }
+        else if (mKnobs[i].paramId == kParamReverbReverseId || mKnobs[i].paramId == kParamDelayReverseId ||
+                 mKnobs[i].paramId == kParamCabinetId)
         {
             valueText = mKnobs[i].value > 0.5f ? L"On" : L"Off";
         }
@@ -543,8 +596,12 @@ void PluginEditor::onMouseDown(int x, int y)
                         mKnobs[i].paramId == kParamModBypassId ||
                         mKnobs[i].paramId == kParamReverbReverseId ||
                         mKnobs[i].paramId == kParamDelayReverseId ||
+                        mKnobs[i].paramId == kParamCabinetId ||
                         mKnobs[i].paramId == kParamDistTypeId ||
-                        mKnobs[i].paramId == kParamModTypeId);
+                        mKnobs[i].paramId == kParamModTypeId ||
+                        mKnobs[i].paramId == kParamOversamplingId ||
+                        mKnobs[i].paramId == kParamAmpModelId ||
+                        mKnobs[i].paramId == kParamDistAntialiasId);
         
         bool clicked = false;
         
@@ -579,16 +636,17 @@ void PluginEditor::onMouseDown(int x, int y)
                     mKnobs[i].paramId == kParamDelayBypassId ||
                     mKnobs[i].paramId == kParamModBypassId ||
                     mKnobs[i].paramId == kParamReverbReverseId ||
-                    mKnobs[i].paramId == kParamDelayReverseId) {
+                    mKnobs[i].paramId == kParamDelayReverseId ||
+                    mKnobs[i].paramId == kParamCabinetId) {
                     
                     float newValue = (mKnobs[i].value > 0.5f) ? 0.0f : 1.0f;
                     updateParameter(i, newValue);
                 }
                 // For mode selection buttons, cycle through values
                 else if (mKnobs[i].paramId == kParamDistTypeId) {
-                    int currentMode = (int)(mKnobs[i].value * 2.0f + 0.5f);
-                    int nextMode = (currentMode + 1) % 3; // 3 distortion types
-                    float newValue = (float)nextMode / 2.0f;
+                    int currentMode = (int)(mKnobs[i].value * (kNumDistTypes - 1) + 0.5f);
+                    int nextMode = (currentMode + 1) % kNumDistTypes;
+                    float newValue = (float)nextMode / (float)(kNumDistTypes - 1);
                     updateParameter(i, newValue);
                 }
                 else if (mKnobs[i].paramId == kParamModTypeId) {
@@ -597,6 +655,48 @@ void PluginEditor::onMouseDown(int x, int y)
                     float newValue = (float)nextMode / 2.0f;
                     updateParameter(i, newValue);
                 }
+                else if (mKnobs[i].paramId == kParamOversamplingId) {
+                    int currentMode = (int)(mKnobs[i].value * 3.0f + 0.5f);
+                    int nextMode = (currentMode + 1) % 4; // 1x, 2x, 4x, 8x
+                    float newValue = (float)nextMode / 3.0f;
+                    updateParameter(i, newValue);
+                }
+                else if (mKnobs[i].paramId == kParamDistAntialiasId) {
+                    int currentMode = (int)(mKnobs[i].value * (kNumDistAntialiasModes - 1) + 0.5f);
+                    int nextMode = (currentMode + 1) % kNumDistAntialiasModes;
+                    float newValue = (float)nextMode / (float)(kNumDistAntialiasModes - 1);
+                    updateParameter(i, newValue);
+                }
+                // Built-in -> triode -> pick a .nam file -> back to built-in
+                // (also when the dialog is cancelled or the file won't load)
+                else if (mKnobs[i].paramId == kParamAmpModelId) {
+                    int currentModel = (int)(mKnobs[i].value * (kNumAmpModels - 1) + 0.5f);
+                    if (currentModel == kAmpModelBuiltIn) {
+                        updateParameter(i, (float)kAmpModelTriode / (float)(kNumAmpModels - 1));
+                    } else if (currentModel == kAmpModelCaptured) {
+                        updateParameter(i, 0.0f);
+                    } else {
+                        char path[MAX_PATH] = "";
+                        OPENFILENAMEA dialog = {};
+                        dialog.lStructSize = sizeof(dialog);
+                        dialog.hwndOwner = mWndHandle;
+                        dialog.lpstrFilter = "NAM models (*.nam)\0*.nam\0All files (*.*)\0*.*\0";
+                        dialog.lpstrFile = path;
+                        dialog.nMaxFile = MAX_PATH;
+                        dialog.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR;
+                        
+                        // The dialog swallows the button release
+                        ReleaseCapture();
+                        mDraggingKnob = -1;
+                        if (GetOpenFileNameA(&dialog) &&
+                            static_cast<PluginController*>(mController)->loadAmpModel(path) == kResultOk)
+                            updateParameter(i, (float)kAmpModelCaptured / (float)(kNumAmpModels - 1));
+                        else
+                            updateParameter(i, 0.0f);
+                        InvalidateRect(mWndHandle, NULL, FALSE);
+                        break;
+                    }
+                }
             }
             
             // Capture mouse
@@ -622,8 +722,12 @@ void PluginEditor::onMouseMove(int x, int y)
                         mKnobs[mDraggingKnob].paramId == kParamModBypassId ||
                         mKnobs[mDraggingKnob].paramId == kParamReverbReverseId ||
                         mKnobs[mDraggingKnob].paramId == kParamDelayReverseId ||
+                        mKnobs[mDraggingKnob].paramId == kParamCabinetId ||
                         mKnobs[mDraggingKnob].paramId == kParamDistTypeId ||
-                        mKnobs[mDraggingKnob].paramId == kParamModTypeId);
+                        mKnobs[mDraggingKnob].paramId == kParamModTypeId ||
+                        mKnobs[mDraggingKnob].paramId == kParamOversamplingId ||
+                        mKnobs[mDraggingKnob].paramId == kParamAmpModelId ||
+                        mKnobs[mDraggingKnob].paramId == kParamDistAntialiasId);
         
         // Only allow dragging for continuous parameters (knobs), not switches
         if (!isSwitch)
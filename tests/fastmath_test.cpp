@@ -0,0 +1,102 @@
+#include "dsp/fastmath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace MyVSTPlugin;
+
+//-----------------------------------------------------------------------------
+// Exhaustive accuracy test of the fast math
+//
+// Runs every finite float in each function's stated range through the float
+// version and compares it with the standard library in double, then checks
+// the maximum error against the figure documented in fastmath.h. The sweep is
+// split across the hardware threads; it still takes a while, so the target is
+// only built with AMNEZIAGAZE_BUILD_TESTS.
+//-----------------------------------------------------------------------------
+
+namespace {
+
+struct Result
+{
+    double maxError;
+    float worstInput;
+};
+
+float fromBits(uint32_t bits)
+{
+    float x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Largest error of fast against reference over the finite floats in
+// [low, high], absolute, or relative to the reference
+template <typename Fast, typename Reference>
+Result sweep(Fast fast, Reference reference, float low, float high, bool relative)
+{
+    const unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Result> results(numThreads, Result{0.0, 0.0f});
+    std::vector<std::thread> threads;
+
+    // Every bit pattern once; each thread takes an interleaved share
+    for (unsigned t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            Result& result = results[t];
+            for (uint64_t bits = t; bits <= 0xffffffffu; bits += numThreads) {
+                const float x = fromBits((uint32_t)bits);
+                if (!std::isfinite(x) || x < low || x > high)
+                    continue;
+
+                const double exact = reference((double)x);
+                double error = std::fabs((double)fast(x) - exact);
+                if (relative)
+                    error /= std::fabs(exact);
+                if (error > result.maxError) {
+                    result.maxError = error;
+                    result.worstInput = x;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    Result worst{0.0, 0.0f};
+    for (const Result& result : results) {
+        if (result.maxError > worst.maxError)
+            worst = result;
+    }
+    return worst;
+}
+
+bool check(const char* name, const Result& result, double bound)
+{
+    const bool passed = result.maxError <= bound;
+    std::printf("%-5s max error %.3g at %.9g (bound %.3g) %s\n", name, result.maxError,
+        (double)result.worstInput, bound, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+} // namespace
+
+int main()
+{
+    const float maxFloat = 3.40282346638528859812e+38f;
+    bool passed = true;
+
+    passed &= check("tanh", sweep([](float x) { return fastTanh(x); },
+        [](double x) { return std::tanh(x); }, -maxFloat, maxFloat, false), 4.2e-7);
+
+    passed &= check("sin", sweep([](float x) { return fastSin(x); },
+        [](double x) { return std::sin(x); }, -1000.0f, 1000.0f, false), 2.3e-7);
+
+    passed &= check("exp", sweep([](float x) { return fastExp(x); },
+        [](double x) { return std::exp(x); }, -87.0f, 88.0f, true), 2.6e-7);
+
+    return passed ? 0 : 1;
+}